@@ -6,6 +6,7 @@
 
 #include <stddef.h>
 
+#include "Modulator.hpp"
 #include "PTT.hpp"
 #include "Log.h"
 
@@ -62,12 +63,31 @@ const int16_t sin_table[SIN_TABLE_LEN] = {
 };
 
 
-struct AFSKModulator {
-
-    static const size_t DAC_BUFFER_LEN = 44;
-    static const size_t BIT_LEN = DAC_BUFFER_LEN / 2;
-    static const size_t MARK_SKIP = 12;
-    static const size_t SPACE_SKIP = 22;
+/**
+ * AFSK modulator.  One bit is sent per DAC DMA half-transfer.  The tones
+ * are generated by stepping through sin_table, which holds one cycle of
+ * SAMPLE_RATE / SIN_TABLE_LEN (100Hz), so the tones must be multiples of
+ * 100Hz.
+ *
+ * @tparam MARK is the mark tone frequency.
+ * @tparam SPACE is the space tone frequency.
+ * @tparam BAUD is the bit rate; it must divide the sample rate.
+ */
+template <uint32_t MARK, uint32_t SPACE, uint32_t BAUD>
+struct BasicAFSKModulator : Modulator {
+
+    static const uint32_t SAMPLE_RATE = 26400;
+    static const uint32_t BIT_RATE = BAUD;
+    static const size_t BIT_LEN = SAMPLE_RATE / BIT_RATE;
+    static const size_t DAC_BUFFER_LEN = BIT_LEN * 2;
+    static const size_t MARK_SKIP = MARK * SIN_TABLE_LEN / SAMPLE_RATE;
+    static const size_t SPACE_SKIP = SPACE * SIN_TABLE_LEN / SAMPLE_RATE;
+
+    static_assert(SAMPLE_RATE % BIT_RATE == 0,
+        "A bit must be a whole number of samples");
+    static_assert(MARK_SKIP * SAMPLE_RATE == MARK * SIN_TABLE_LEN
+        and SPACE_SKIP * SAMPLE_RATE == SPACE * SIN_TABLE_LEN,
+        "The tones must be multiples of the sine table frequency");
 
     size_t pos_{0};
     int running_{-1};
@@ -77,7 +97,7 @@ struct AFSKModulator {
     uint16_t volume_{4096};
     uint16_t buffer_[DAC_BUFFER_LEN];
 
-    AFSKModulator(osMessageQId queue, PTT* ptt)
+    BasicAFSKModulator(osMessageQId queue, PTT* ptt)
     : dacOutputQueueHandle_(queue), ptt_(ptt)
     {
         for (size_t i = 0; i != DAC_BUFFER_LEN; i++)
@@ -103,6 +123,10 @@ struct AFSKModulator {
 
     void set_twist(uint8_t twist) {twist_ = twist;}
 
+    uint32_t bit_rate() const {return BIT_RATE;}
+
+    bool idle() const {return running_ == -1;}
+
     void send(bool bit) {
         switch (running_) {
         case -1:
@@ -113,6 +137,7 @@ struct AFSKModulator {
             fill_last(bit);
             running_ = 1;
             ptt_->on();
+            set_sample_rate(SAMPLE_RATE);
             HAL_TIM_Base_Start(&htim7);
             HAL_DAC_Start_DMA(&hdac1, DAC_CHANNEL_1, (uint32_t*) buffer_, DAC_BUFFER_LEN, DAC_ALIGN_12B_R);
             break;
@@ -149,11 +174,11 @@ struct AFSKModulator {
         }
     }
 
-    void fill_first(bool bit) {
+    void fill_first(uint32_t bit) {
         fill(buffer_, bit);
     }
 
-    void fill_last(bool bit) {
+    void fill_last(uint32_t bit) {
         fill(buffer_ + BIT_LEN, bit);
     }
 
@@ -186,6 +211,12 @@ struct AFSKModulator {
     }
 };
 
+/// Bell 202 VHF packet.
+typedef BasicAFSKModulator<1200, 2200, 1200> AFSKModulator;
+
+/// HF packet, 200Hz shift.
+typedef BasicAFSKModulator<1600, 1800, 300> Afsk300Modulator;
+
 }} // mobilinkd::tnc
 
 
@@ -0,0 +1,127 @@
+// Copyright 2019 Rob Riggs <rob@mobilinkd.com>
+// All rights reserved.
+
+#ifndef MOBILINKD__TNC__ADAPTIVE_TWIST_HPP_
+#define MOBILINKD__TNC__ADAPTIVE_TWIST_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace mobilinkd { namespace tnc {
+
+/**
+ * Move the demodulator branches toward the twist of the received signal.
+ * The branches are SPACING dB apart, centered on center().
+ *
+ * Each packet is usually decoded by more than one branch.  The branches
+ * that decoded a packet are recorded; when only the lowest or only the
+ * highest twist branch of the two decoded it, that is a vote to move the
+ * center that way.  After every PACKETS packets the center moves one
+ * branch (SPACING dB) toward the side with more votes, if it leads by at
+ * least MARGIN.  A strong signal that every branch decodes does not move
+ * anything, and neither does one that no branch decodes.
+ *
+ * Moving by SPACING keeps the branches on the same 3dB grid.  The replay
+ * host test checks that the branches move toward frames that are all 9dB
+ * off in either direction.
+ *
+ * The caller applies the new twist with the demodulator running; it
+ * should wait until no branch is locked so that no frame is lost.
+ *
+ * @tparam BRANCHES is the number of demodulator branches (odd).
+ */
+template <size_t BRANCHES>
+struct AdaptiveTwist
+{
+    static_assert(BRANCHES % 2 == 1 and BRANCHES <= 8,
+        "BRANCHES must be odd and fit in the branch mask");
+
+    static constexpr int SPACING = 3;       // dB between branches.
+    static constexpr int MIN_TWIST = -6;    // Range of the emphasis filters.
+    static constexpr int MAX_TWIST = 12;
+    static constexpr int HALF_SPAN = SPACING * int(BRANCHES / 2);
+    static constexpr uint32_t PACKETS = 8;  // Packets per decision.
+    static constexpr uint32_t MARGIN = 4;
+
+    static constexpr uint8_t LOW = 1;
+    static constexpr uint8_t HIGH = 1 << (BRANCHES - 1);
+
+    int center_;
+    uint32_t key_;          // The packet being decoded.
+    uint8_t branches_;      // The branches that have decoded it.
+    uint32_t packets_;
+    uint32_t down_;
+    uint32_t up_;
+    bool changed_;
+
+    AdaptiveTwist(int center)
+    : center_(clamp(center)), key_(0), branches_(0), packets_(0)
+    , down_(0), up_(0), changed_(false)
+    {}
+
+    static int clamp(int center)
+    {
+        return std::min(std::max(center, MIN_TWIST + HALF_SPAN),
+            MAX_TWIST - HALF_SPAN);
+    }
+
+    int center() const { return center_; }
+
+    /// The twist of one branch, in dB.
+    int operator[](size_t branch) const
+    {
+        return center_ + SPACING * (int(branch) - int(BRANCHES / 2));
+    }
+
+    /**
+     * Record a decoded frame.  Frames with the same key from different
+     * branches are the same packet.
+     *
+     * @param branch is the branch that decoded the frame.
+     * @param key identifies the packet (e.g. DuplicateFilter::key()).
+     * @return true if the center has moved.  It stays true until
+     *  applied() is called.
+     */
+    bool operator()(size_t branch, uint32_t key)
+    {
+        if (key != key_) {
+            if (branches_) vote();
+            key_ = key;
+            branches_ = 0;
+        }
+        branches_ |= 1 << branch;
+        return changed_;
+    }
+
+    bool changed() const { return changed_; }
+    void applied() { changed_ = false; }
+
+private:
+
+    void vote()
+    {
+        if ((branches_ & (LOW | HIGH)) == LOW) ++down_;
+        else if ((branches_ & (LOW | HIGH)) == HIGH) ++up_;
+
+        if (++packets_ < PACKETS) return;
+
+        int center = center_;
+        if (down_ >= up_ + MARGIN) center -= SPACING;
+        else if (up_ >= down_ + MARGIN) center += SPACING;
+        center = clamp(center);
+
+        if (center != center_) {
+            center_ = center;
+            changed_ = true;
+        }
+
+        packets_ = 0;
+        down_ = 0;
+        up_ = 0;
+    }
+};
+
+}} // mobilinkd::tnc
+
+#endif // MOBILINKD__TNC__ADAPTIVE_TWIST_HPP_
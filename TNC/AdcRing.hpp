@@ -0,0 +1,131 @@
+// Copyright 2019 Rob Riggs <rob@mobilinkd.com>
+// All rights reserved.
+
+#ifndef MOBILINKD__TNC__ADC_RING_HPP_
+#define MOBILINKD__TNC__ADC_RING_HPP_
+
+#include "cmsis_os.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace mobilinkd { namespace tnc {
+
+/**
+ * The ADC DMA buffer, shared with the audio input task without copying.
+ *
+ * The DMA runs in circular mode over SLOT_COUNT blocks of BLOCK_SIZE
+ * samples.  The DMA interrupts when each half of the ring is full; the
+ * interrupt only posts the number of that half to the queue.  The task
+ * then reads the blocks of that half in place, one at a time, with
+ * acquire() and release().  Releasing the last block of a half hands it
+ * back to the DMA.  With two blocks, each block is posted as it fills.
+ *
+ * The task has until the DMA wraps back around to finish with a half,
+ * which is SLOT_COUNT / 2 blocks of time.  If it falls behind, the DMA
+ * overwrites samples that are still being read (an overrun), and a half
+ * that has not been released is not posted again (a drop).  Both are
+ * counted.
+ *
+ * @tparam BLOCK_SIZE is the number of samples in a block.
+ * @tparam SLOT_COUNT is the number of blocks in the ring (even).
+ */
+template <size_t BLOCK_SIZE, size_t SLOT_COUNT>
+struct AdcRing
+{
+    static_assert(SLOT_COUNT >= 2 and SLOT_COUNT % 2 == 0,
+        "The ring must have two equal halves");
+
+    static constexpr size_t HALF_SLOTS = SLOT_COUNT / 2;
+    static constexpr size_t SIZE = BLOCK_SIZE * SLOT_COUNT;    ///< In samples.
+
+    alignas(4) uint16_t buffer_[SIZE];
+    std::atomic<bool> busy_[2];     ///< Half posted and not yet released.
+    osMessageQId queue_;
+    size_t slot_;                   ///< The block being read.
+    size_t remaining_;              ///< Blocks left in the half being read.
+    uint32_t overruns_;
+    uint32_t drops_;
+
+    AdcRing()
+    : buffer_(), busy_(), queue_(0), slot_(0), remaining_(0)
+    , overruns_(0), drops_(0)
+    {}
+
+    /// Set the queue used to post completed halves.
+    void init(osMessageQId queue) { queue_ = queue; }
+
+    /// The DMA buffer, for HAL_ADC_Start_DMA().
+    uint32_t* buffer() { return reinterpret_cast<uint32_t*>(buffer_); }
+
+    /**
+     * Forget any posted halves.  Call this before starting the DMA.
+     */
+    void reset()
+    {
+        while (osMessageGet(queue_, 0).status == osEventMessage);
+        busy_[0] = false;
+        busy_[1] = false;
+        slot_ = 0;
+        remaining_ = 0;
+        overruns_ = 0;
+        drops_ = 0;
+    }
+
+    /**
+     * Post a full half of the ring.  Called from the DMA interrupt.
+     *
+     * @param half is 0 for the half-transfer interrupt and 1 for the
+     *  transfer-complete interrupt.
+     */
+    void complete(size_t half)
+    {
+        // The DMA is now writing the other half.
+        if (busy_[half ^ 1].load(std::memory_order_relaxed)) ++overruns_;
+
+        if (busy_[half].exchange(true, std::memory_order_relaxed)) {
+            ++drops_;
+            return;
+        }
+
+        if (osMessagePut(queue_, half, 0) != osOK) {
+            busy_[half].store(false, std::memory_order_relaxed);
+            ++drops_;
+        }
+    }
+
+    /**
+     * Get the next block of samples, waiting for the DMA if necessary.
+     * The same block is returned until it is released.
+     *
+     * @return BLOCK_SIZE samples, or nullptr on timeout.
+     */
+    const uint16_t* acquire(uint32_t timeout = osWaitForever)
+    {
+        if (remaining_ == 0) {
+            osEvent evt = osMessageGet(queue_, timeout);
+            if (evt.status != osEventMessage) return nullptr;
+            slot_ = evt.value.v * HALF_SLOTS;
+            remaining_ = HALF_SLOTS;
+        }
+        return buffer_ + slot_ * BLOCK_SIZE;
+    }
+
+    /// Finish with the block returned by acquire().
+    void release()
+    {
+        if (remaining_ == 0) return;
+        if (--remaining_ == 0) {
+            busy_[slot_ / HALF_SLOTS].store(false, std::memory_order_release);
+        }
+        ++slot_;
+    }
+
+    uint32_t overruns() const { return overruns_; }
+    uint32_t drops() const { return drops_; }
+};
+
+}} // mobilinkd::tnc
+
+#endif // MOBILINKD__TNC__ADC_RING_HPP_
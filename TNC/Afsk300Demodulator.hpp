@@ -0,0 +1,119 @@
+// Copyright 2019 Rob Riggs <rob@mobilinkd.com>
+// All rights reserved.
+
+#ifndef MOBILINKD__TNC__AFSK300_DEMODULATOR_HPP_
+#define MOBILINKD__TNC__AFSK300_DEMODULATOR_HPP_
+
+#include <arm_math.h>
+#include "AudioInput.hpp"
+#include "CorrelatorDemodulator.hpp"
+#include "HdlcDecoder.hpp"
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+namespace mobilinkd { namespace tnc { namespace afsk300 {
+
+/// HF packet tones (Bell 103 style, 200Hz shift) and bit rate.
+constexpr const uint32_t MARK_FREQ = 1600;
+constexpr const uint32_t SPACE_FREQ = 1800;
+constexpr const uint32_t BIT_RATE = 300;
+
+/// The number of tone offsets and the spacing between them, in Hz.
+constexpr const size_t OFFSETS = 5;
+constexpr const int OFFSET_SPACING = 40;
+
+/**
+ * Demodulate the same audio at several tone offsets.  An SSB receiver
+ * that is mistuned by a few tens of Hz moves both tones; with only 200Hz
+ * between them, a single demodulator loses most packets once the error is
+ * more than about 50Hz.  Each offset is a correlator demodulator with its
+ * tones moved by OFFSET_SPACING from the next one, centered on the
+ * nominal tones.  The copies of a packet decoded at more than one offset
+ * are removed by the duplicate filter.
+ *
+ * The frame at index i was decoded at offset(i).
+ *
+ * @tparam SYMBOL_RATE is the symbol rate; it must divide the sample rate.
+ * @tparam N is the number of offsets (odd).
+ */
+template <uint32_t SYMBOL_RATE, size_t N,
+    size_t BLOCK_SIZE = audio::ADC_BUFFER_SIZE>
+struct OffsetDemodulator
+{
+    static_assert(audio::SAMPLE_RATE % SYMBOL_RATE == 0,
+        "The correlator window must be a whole number of samples");
+    static_assert(N % 2 == 1, "The offsets must be centered");
+
+    static constexpr size_t WINDOW = audio::SAMPLE_RATE / SYMBOL_RATE;
+
+    typedef CorrelatorDemodulator<1, WINDOW, BLOCK_SIZE> correlator_type;
+    typedef std::array<hdlc::IoFrame*, N> result_type;
+
+    std::array<correlator_type, N> correlators_;
+
+    OffsetDemodulator(uint32_t mark, uint32_t space)
+    : correlators_(make_correlators(mark, space, std::make_index_sequence<N>()))
+    {}
+
+    static constexpr int offset(size_t i)
+    {
+        return OFFSET_SPACING * (int(i) - int(N / 2));
+    }
+
+    static constexpr size_t size() { return N; }
+
+    /// Clear the correlator history.  HF audio has no twist to correct.
+    void init()
+    {
+        for (auto& correlator : correlators_) correlator.init(0, 0);
+    }
+
+    result_type operator()(const q15_t* samples, size_t len)
+    {
+        result_type result;
+        uint32_t budget = hdlc::FIX_BITS_TRIALS_PER_BLOCK;
+        for (size_t i = 0; i != N; i++) {
+            result[i] = correlators_[i](samples, len, budget)[0];
+        }
+        return result;
+    }
+
+    /// Set the fix bits mode of all offsets and reset their statistics.
+    void fix_bits(hdlc::FixBits mode)
+    {
+        for (auto& correlator : correlators_) correlator.fix_bits(mode);
+    }
+
+    hdlc::FixBitsStats fix_bits_stats() const
+    {
+        hdlc::FixBitsStats result;
+        for (const auto& correlator : correlators_) {
+            result += correlator.fix_bits_stats();
+        }
+        return result;
+    }
+
+    bool locked() const
+    {
+        return std::any_of(correlators_.begin(), correlators_.end(),
+            [](const correlator_type& c) { return c.locked(); });
+    }
+
+private:
+
+    template <size_t... I>
+    static std::array<correlator_type, N> make_correlators(
+        uint32_t mark, uint32_t space, std::index_sequence<I...>)
+    {
+        return {{correlator_type(audio::SAMPLE_RATE, mark + offset(I),
+            space + offset(I), SYMBOL_RATE)...}};
+    }
+};
+
+typedef OffsetDemodulator<BIT_RATE, OFFSETS> Demodulator;
+
+}}} // mobilinkd::tnc::afsk300
+
+#endif // MOBILINKD__TNC__AFSK300_DEMODULATOR_HPP_
@@ -5,38 +5,35 @@
 
 namespace mobilinkd { namespace tnc { namespace afsk1200 {
 
-hdlc::IoFrame* Demodulator::operator()(q15_t* samples, size_t len)
+hdlc::IoFrame* DemodulatorBranch::operator()(const uint32_t* levels, size_t len)
 {
     hdlc::IoFrame* result = 0;
 
-    float* fa = audio_filter_(samples);
+    const uint32_t* bits = delay_line_(levels, len);
 
+    // Unpack to +/-1 for the low-pass filter.
     for (size_t i = 0; i != len; i++) {
-        buffer_[i] = int16_t(fa[i]);
-    }
-
-    for (size_t i = 0; i != len; i++) {
-        bool level = (buffer_[i] >= 0);
-        bool delayed = delay_line_(level);
-        buffer_[i] = (int16_t(level ^ delayed) << 1) - 1;
+        buffer_[i] = (int16_t((bits[i / 32] >> (i % 32)) & 1) << 1) - 1;
     }
 
     auto* fc = lpf_filter_.filter(buffer_);
 
-    for (size_t i = 0; i != len; i++) {
+    for (size_t i = 0; i != len / audio::DECIMATION; i++) {
         bool bit = fc[i] >= 0;
         auto pll = pll_(bit);
 
         if (pll.sample) {
             locked_ = pll.locked;
 
+            if (not hdlc_bits_(nrzi_.decode(bit))) continue;
+
             // We will only ever get one frame because there are
             // not enough bits in a block for more than one.
             if (result) {
-                auto tmp = hdlc_decoder_(nrzi_.decode(bit), true);
+                auto tmp = hdlc_decoder_(hdlc_bits_.byte());
                 if (tmp) hdlc::release(tmp);
             } else {
-                result = hdlc_decoder_(nrzi_.decode(bit), true);
+                result = hdlc_decoder_(hdlc_bits_.byte());
             }
         }
     }
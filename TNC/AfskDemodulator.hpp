@@ -10,64 +10,233 @@
 #include "DigitalPLL.hpp"
 #include "HdlcDecoder.hpp"
 #include "Hysteresis.hpp"
+#include "FilterDesign.hpp"
 #include "FirFilter.hpp"
 #include "NRZI.hpp"
 
 #include <algorithm>
-#include <functional>
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <utility>
 
 namespace mobilinkd { namespace tnc { namespace afsk1200 {
 
+/*
+ * 760Hz low-pass, Hann window.  Designed with 100 taps; the near-zero taps
+ * at each end are removed.
+ *
+ * np.array(firwin(100, 760.0, fs=sample_rate, window='hann') * 32768,
+ *     dtype=int)[2:-2]
+ */
 const size_t LPF_FILTER_LEN = 96;
 
-const q15_t lpf_coeffs[] = {
-    0,     1,     3,     5,     8,    11,    14,    17,    19,    20,    18,    14,
-    7,    -2,   -16,   -33,   -53,   -76,  -101,  -126,  -151,  -174,  -194,  -208,
- -215,  -212,  -199,  -173,  -133,   -79,   -10,    74,   173,   287,   413,   549,
-  693,   842,   993,  1142,  1287,  1423,  1547,  1656,  1747,  1817,  1865,  1889,
- 1889,  1865,  1817,  1747,  1656,  1547,  1423,  1287,  1142,   993,   842,   693,
-  549,   413,   287,   173,    74,   -10,   -79,  -133,  -173,  -199,  -212,  -215,
- -208,  -194,  -174,  -151,  -126,  -101,   -76,   -53,   -33,   -16,    -2,     7,
-   14,    18,    20,    19,    17,    14,    11,     8,     5,     3,     1,     0,
-};
+constexpr auto lpf_coeffs = filter::design::truncate<q15_t, 15>(
+    filter::design::trim<2>(filter::design::firwin<LPF_FILTER_LEN + 4>(
+        760.0, audio::SAMPLE_RATE, filter::design::Window::HANN)));
 
-typedef FirFilter<audio::ADC_BUFFER_SIZE, 9> emphasis_filter_type;
+static_assert(audio::SAMPLE_RATE != 26400
+    or filter::design::fingerprint(lpf_coeffs) == 0x43bfa5b3,
+    "lpf_coeffs does not match the scipy design");
 
-struct Demodulator {
+/// The LPF decimates to DEMOD_SAMPLE_RATE when AFSK_DECIMATION > 1.
+typedef Q15SymmetricFirFilter<audio::ADC_BUFFER_SIZE, LPF_FILTER_LEN,
+    audio::DECIMATION> lpf_filter_type;
 
-    typedef float float_type;
+const size_t EMPHASIS_FILTER_LEN = 9;
+const int EMPHASIS_FRACTION_BITS = 12;
 
-    typedef std::function<float_type(float_type)> filter_function_type;
+/**
+ * The part of the demodulator that follows the emphasis filter.  This is
+ * the delay-line discriminator, the low-pass filter, the clock recovery
+ * PLL, the NRZI decoder and the HDLC decoder.  Each twist branch has its
+ * own instance of this.
+ */
+struct DemodulatorBranch {
 
     static const size_t SYMBOL_RATE = 1200;
 
-    typedef BaseDigitalPLL<float_type> DPLL;
+    typedef FixedDigitalPLL DPLL;
 
     size_t sample_rate_;
-    emphasis_filter_type& audio_filter_;
-    libafsk::FixedDelayLine<40> delay_line_;
+    libafsk::BlockDelayLine<audio::ADC_BUFFER_SIZE> delay_line_;
     DPLL pll_;
-    Q15FirFilter<audio::ADC_BUFFER_SIZE, LPF_FILTER_LEN> lpf_filter_;
+    lpf_filter_type lpf_filter_;
     libafsk::NRZI nrzi_;
+    hdlc::BitPacker hdlc_bits_;
     hdlc::NewDecoder hdlc_decoder_;
     bool locked_;
     q15_t buffer_[audio::ADC_BUFFER_SIZE];
 
-    Demodulator(size_t sample_rate, emphasis_filter_type& c)
+    DemodulatorBranch(size_t sample_rate)
     : sample_rate_(sample_rate)
-    , audio_filter_(c)
     , delay_line_(sample_rate, 0.000448)
-    , pll_(sample_rate, SYMBOL_RATE)
+    , pll_(sample_rate / audio::DECIMATION, SYMBOL_RATE)
     , nrzi_(), hdlc_decoder_(false), locked_(false)
     {
-        lpf_filter_.init(lpf_coeffs);
+        lpf_filter_.init(lpf_coeffs.data());
     }
 
-    hdlc::IoFrame* operator()(q15_t* samples, size_t len);
+    // The filter instance points into the object; it must not be copied.
+    DemodulatorBranch(const DemodulatorBranch&) = delete;
+    DemodulatorBranch& operator=(const DemodulatorBranch&) = delete;
+
+    /**
+     * Demodulate a block of emphasis-filtered samples.
+     *
+     * @param levels are the signs of the emphasis filter output, one bit
+     *  per sample (1 for >= 0), packed LSB-first.
+     * @param len is the number of samples, at most ADC_BUFFER_SIZE.
+     * @return a decoded frame or nullptr.
+     */
+    hdlc::IoFrame* operator()(const uint32_t* levels, size_t len);
 
     bool locked() const {return locked_;}
 };
 
+// The band-pass filter and the emphasis filters are fed ADC samples less
+// the virtual ground, which are within +/-vref.
+static_assert(audio::vref < Q15_PREADD_LIMIT,
+    "ADC samples can saturate the pre-added filter taps");
+
+/**
+ * Demodulate the same audio with several emphasis (twist) filters in one
+ * pass.  Each sample is loaded once and multiplied by the taps of every
+ * branch.
+ *
+ * The emphasis filters are Q12 fixed-point and symmetric.  The samples
+ * that share a tap are added first, so each SMLAD does four taps; as with
+ * Q15SymmetricFirFilter, the input must stay within +/-Q15_PREADD_LIMIT
+ * for the pairs not to saturate.  Only the sign of the emphasis filter
+ * output is used by the discriminator, so the output is packed into one
+ * bit per sample for the block delay line.
+ */
+template <size_t BRANCHES, size_t BLOCK_SIZE = audio::ADC_BUFFER_SIZE>
+struct FusedDemodulator {
+
+    typedef std::array<hdlc::IoFrame*, BRANCHES> result_type;
+    typedef TFixedFirCoefficients<EMPHASIS_FILTER_LEN, EMPHASIS_FRACTION_BITS>
+        coefficients_type;
+
+    static constexpr size_t HISTORY = EMPHASIS_FILTER_LEN - 1;
+    static constexpr size_t HALF_SIZE = EMPHASIS_FILTER_LEN / 2;
+    static constexpr size_t TAP_PAIRS = HALF_SIZE / 2;
+
+    static_assert(EMPHASIS_FILTER_LEN % 2 == 1 and HALF_SIZE % 2 == 0,
+        "The emphasis filter must have a center tap and an even number of tap pairs");
+    static constexpr size_t LEVEL_WORDS = (BLOCK_SIZE + 31) / 32;
+
+    // The float filter truncated toward zero; everything above -1.0 was
+    // a non-negative level.
+    static constexpr int32_t LEVEL_THRESHOLD = -(1 << EMPHASIS_FRACTION_BITS);
+
+    int32_t taps_[TAP_PAIRS][BRANCHES];         // Tap pairs, by branch.
+    int32_t center_tap_[BRANCHES];
+    q15_t samples_[BLOCK_SIZE + HISTORY];
+    uint32_t levels_[BRANCHES][LEVEL_WORDS];
+    std::array<DemodulatorBranch, BRANCHES> branches_;
+
+    FusedDemodulator(size_t sample_rate)
+    : taps_(), center_tap_(), samples_(), levels_()
+    , branches_(make_branches(sample_rate, std::make_index_sequence<BRANCHES>()))
+    {}
+
+    /// Set the emphasis filter for one branch and clear the filter history.
+    void init(size_t branch, const coefficients_type& c)
+    {
+        taps(branch, c);
+        std::fill(samples_, samples_ + HISTORY, 0);
+    }
+
+    /**
+     * Set the emphasis filter for one branch.  The filter history is kept
+     * so that this can be used while the demodulator is running.
+     */
+    void taps(size_t branch, const coefficients_type& c)
+    {
+        for (size_t i = 0; i != HALF_SIZE; i++) {
+            assert(c.taps[i] == c.taps[EMPHASIS_FILTER_LEN - 1 - i]);
+        }
+        for (size_t i = 0; i != TAP_PAIRS; i++) {
+            taps_[i][branch] = uint16_t(c.taps[i * 2])
+                | (uint32_t(uint16_t(c.taps[i * 2 + 1])) << 16);
+        }
+        center_tap_[branch] = c.taps[HALF_SIZE];
+    }
+
+    static constexpr size_t size() { return BRANCHES; }
+
+    result_type operator()(const q15_t* samples, size_t len)
+    {
+        std::copy(samples, samples + len, samples_ + HISTORY);
+        memset(levels_, 0, sizeof(levels_));
+
+        for (size_t i = 0; i != len; i++) {
+            const q15_t* x = samples_ + i;
+            int32_t accum[BRANCHES] = {};
+            for (size_t j = 0; j != TAP_PAIRS; j++) {
+                const uint32_t front = _SIMD32_OFFSET(x + j * 2);
+                const uint32_t back = __ROR(
+                    _SIMD32_OFFSET(x + EMPHASIS_FILTER_LEN - 2 - j * 2), 16);
+                const uint32_t pair = __QADD16(front, back);
+                for (size_t k = 0; k != BRANCHES; k++) {
+                    accum[k] = __SMLAD(pair, taps_[j][k], accum[k]);
+                }
+            }
+            const int32_t center = x[HALF_SIZE];
+            for (size_t k = 0; k != BRANCHES; k++) {
+                accum[k] += center * center_tap_[k];
+                levels_[k][i / 32] |= uint32_t(accum[k] > LEVEL_THRESHOLD) << (i % 32);
+            }
+        }
+
+        std::copy(samples_ + len, samples_ + len + HISTORY, samples_);
+
+        result_type result;
+        uint32_t budget = hdlc::FIX_BITS_TRIALS_PER_BLOCK;
+        for (size_t k = 0; k != BRANCHES; k++) {
+            auto& decoder = branches_[k].hdlc_decoder_;
+            decoder.fix_bits_budget = budget;
+            result[k] = branches_[k](levels_[k], len);
+            budget = decoder.fix_bits_budget;
+        }
+        return result;
+    }
+
+    /// Set the fix bits mode of all branches and reset their statistics.
+    void fix_bits(hdlc::FixBits mode)
+    {
+        for (auto& branch : branches_) {
+            branch.hdlc_decoder_.fix_bits_mode = mode;
+            branch.hdlc_decoder_.fix_bits_stats = hdlc::FixBitsStats();
+        }
+    }
+
+    hdlc::FixBitsStats fix_bits_stats() const
+    {
+        hdlc::FixBitsStats result;
+        for (const auto& branch : branches_) {
+            result += branch.hdlc_decoder_.fix_bits_stats;
+        }
+        return result;
+    }
+
+    bool locked() const
+    {
+        return std::any_of(branches_.begin(), branches_.end(),
+            [](const DemodulatorBranch& b) { return b.locked(); });
+    }
+
+private:
+
+    template <size_t... I>
+    static std::array<DemodulatorBranch, BRANCHES> make_branches(
+        size_t sample_rate, std::index_sequence<I...>)
+    {
+        return {{(void(I), DemodulatorBranch(sample_rate))...}};
+    }
+};
+
 
 }}} // mobilinkd::tnc::afsk1200
 
@@ -2,15 +2,23 @@
 // All rights reserved.
 
 #include "AudioInput.hpp"
+#include "AdaptiveTwist.hpp"
 #include "AfskDemodulator.hpp"
+#include "Afsk300Demodulator.hpp"
+#include "CorrelatorDemodulator.hpp"
+#include "Fsk9600Demodulator.hpp"
+#include "Modem.hpp"
 #include "AudioLevel.hpp"
+#include "EnergyDcd.hpp"
+#include "InputMonitor.hpp"
+#include "InputTracker.hpp"
+#include "LevelMeter.hpp"
 #include "Log.h"
 #include "KissHardware.hpp"
 #include "GPIO.hpp"
 #include "HdlcFrame.hpp"
-#include "memory.hpp"
-#include "IirFilter.hpp"
 #include "FilterCoefficients.hpp"
+#include "FilterDesign.hpp"
 #include "PortInterface.hpp"
 #include "Goertzel.h"
 #include "DCD.h"
@@ -19,7 +27,7 @@
 #include "stm32l4xx_hal.h"
 
 #include <algorithm>
-#include <numeric>
+#include <array>
 #include <cstring>
 #include <cstdint>
 #include <atomic>
@@ -28,38 +36,21 @@ extern osMessageQId ioEventQueueHandle;
 
 extern "C" void SystemClock_Config(void);
 
-// 1kB
-typedef mobilinkd::tnc::memory::Pool<
-    8, mobilinkd::tnc::audio::ADC_BUFFER_SIZE * 2> adc_pool_type;
-adc_pool_type adcPool;
-
 // DMA Conversion first half complete.
 extern "C" void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef*) {
-    using namespace mobilinkd::tnc::audio;
-
-    auto block = adcPool.allocate();
-    if (!block) return;
-    memmove(block->buffer, adc_buffer, ADC_BUFFER_SIZE * 2);
-    auto status = osMessagePut(adcInputQueueHandle, (uint32_t) block, 0);
-    if (status != osOK) adcPool.deallocate(block);
+    mobilinkd::tnc::audio::adc_ring.complete(0);
 }
 
 // DMA Conversion second half complete.
 extern "C" void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef*) {
-    using namespace mobilinkd::tnc::audio;
-
-    auto block = adcPool.allocate();
-    if (!block) return;
-    memmove(block->buffer, adc_buffer + DMA_TRANSFER_SIZE, ADC_BUFFER_SIZE * 2);
-    auto status = osMessagePut(adcInputQueueHandle, (uint32_t) block, 0);
-    if (status != osOK) adcPool.deallocate(block);
+    mobilinkd::tnc::audio::adc_ring.complete(1);
 }
 
 extern "C" void HAL_ADC_ErrorCallback(ADC_HandleTypeDef* /* hadc */) {
     using namespace mobilinkd::tnc::audio;
 
     // __HAL_ADC_CLEAR_FLAG(hadc, (ADC_FLAG_EOC | ADC_FLAG_EOS | ADC_FLAG_OVR));
-    // HAL_DMA_Start(hadc->DMA_Handle, (uint32_t)&hadc->Instance->DR, (uint32_t)adc_buffer, ADC_BUFFER_SIZE * 2);
+    // HAL_DMA_Start(hadc->DMA_Handle, (uint32_t)&hadc->Instance->DR, adc_ring.buffer(), adc_ring_type::SIZE);
 }
 
 extern "C" void startAudioInputTask(void const*) {
@@ -67,7 +58,7 @@ extern "C" void startAudioInputTask(void const*) {
     using namespace mobilinkd::tnc::audio;
     DEBUG("startAudioInputTask");
 
-    adcPool.init();
+    adc_ring.init(adcInputQueueHandle);
 
     uint8_t adcState = mobilinkd::tnc::audio::IDLE;
 
@@ -132,182 +123,556 @@ extern "C" void startAudioInputTask(void const*) {
 
 namespace mobilinkd { namespace tnc { namespace audio {
 
-/*
- * Generated with Scipy Filter, 152 coefficients, 1100-2300Hz bandpass,
- * Hann window, starting and ending 0 value coefficients removed.
- *
- * np.array(
- *  firwin2(152,
- *      [
- *          0.0,
- *          1000.0/(sample_rate/2),
- *          1100.0/(sample_rate/2),
- *          2350.0/(sample_rate/2),
- *          2500.0/(sample_rate/2),
- *          1.0
- *      ],
- *      [0,0,1,1,0,0],
- *      antisymmetric = False,
- *      window='hann') * 32768,
- *  dtype=int)[10:-10]
- */
-constexpr size_t FILTER_TAP_NUM = 132;
-const q15_t bpf_coeffs[] = {
-    4,     0,    -5,   -10,   -13,   -12,    -9,    -4,    -2,    -4,   -12,   -26,
-  -41,   -52,   -51,   -35,    -3,    39,    83,   117,   131,   118,    83,    36,
-   -6,   -32,   -30,    -3,    36,    67,    66,    19,   -74,  -199,  -323,  -408,
- -421,  -344,  -187,    17,   218,   364,   417,   369,   247,   106,    14,    26,
-  166,   407,   676,   865,   866,   605,    68,  -675, -1484, -2171, -2547, -2471,
--1895,  -882,   394,  1692,  2747,  3337,  3337,  2747,  1692,   394,  -882, -1895,
--2471, -2547, -2171, -1484,  -675,    68,   605,   866,   865,   676,   407,   166,
-   26,    14,   106,   247,   369,   417,   364,   218,    17,  -187,  -344,  -421,
- -408,  -323,  -199,   -74,    19,    66,    67,    36,    -3,   -30,   -32,    -6,
-   36,    83,   118,   131,   117,    83,    39,    -3,   -35,   -51,   -52,   -41,
-  -26,   -12,    -4,    -2,    -4,    -9,   -12,   -13,   -10,    -5,     0,     4,
-};
-
-uint32_t adc_buffer[ADC_BUFFER_SIZE];       // Two samples per element.
+adc_ring_type adc_ring;
 
-typedef Q15FirFilter<ADC_BUFFER_SIZE, FILTER_TAP_NUM> audio_filter_type;
+typedef Q15SymmetricFirFilter<ADC_BUFFER_SIZE, FILTER_TAP_NUM> audio_filter_type;
 
 audio_filter_type audio_filter;
 
-mobilinkd::tnc::afsk1200::emphasis_filter_type filter_1;
-mobilinkd::tnc::afsk1200::emphasis_filter_type filter_2;
-mobilinkd::tnc::afsk1200::emphasis_filter_type filter_3;
+#if AFSK_CORRELATOR
+typedef mobilinkd::tnc::CorrelatorDemodulator<3, SAMPLE_RATE / 1200> demodulator_type;
+#else
+typedef mobilinkd::tnc::afsk1200::FusedDemodulator<3> demodulator_type;
+#endif
 
-mobilinkd::tnc::afsk1200::Demodulator& getDemod1(const TFirCoefficients<9>& f) __attribute__((noinline));
-mobilinkd::tnc::afsk1200::Demodulator& getDemod2(const TFirCoefficients<9>& f) __attribute__((noinline));
-mobilinkd::tnc::afsk1200::Demodulator& getDemod3(const TFirCoefficients<9>& f) __attribute__((noinline));
+demodulator_type& getDemodulator() __attribute__((noinline));
 
-mobilinkd::tnc::afsk1200::Demodulator& getDemod1(const TFirCoefficients<9>& f) {
-    filter_1.init(f);
-    static mobilinkd::tnc::afsk1200::Demodulator instance(26400, filter_1);
+demodulator_type& getDemodulator() {
+#if AFSK_CORRELATOR
+    static demodulator_type instance(SAMPLE_RATE, 1200, 2200, 1200);
+#else
+    static demodulator_type instance(SAMPLE_RATE);
+#endif
     return instance;
 }
 
-mobilinkd::tnc::afsk1200::Demodulator& getDemod2(const TFirCoefficients<9>& f) {
-    filter_2.init(f);
-    static mobilinkd::tnc::afsk1200::Demodulator instance(26400, filter_2);
+afsk300::Demodulator& getAfsk300Demodulator() {
+    static afsk300::Demodulator instance(afsk300::MARK_FREQ, afsk300::SPACE_FREQ);
     return instance;
 }
 
-mobilinkd::tnc::afsk1200::Demodulator& getDemod3(const TFirCoefficients<9>& f) {
-    filter_3.init(f);
-    static mobilinkd::tnc::afsk1200::Demodulator instance(26400, filter_3);
+fsk9600::Demodulator& getFsk9600Demodulator() {
+    static fsk9600::Demodulator instance;
     return instance;
 }
 
+/// Set the twist (emphasis) of one branch, in dB, while running.
+void setBranchTwist(demodulator_type& demod, size_t branch, int twist)
+{
+#if AFSK_CORRELATOR
+    demod.twist(branch, twist);
+#else
+    demod.taps(branch, *filter::fir::AfskFixedFilters[twist + 6]);
+#endif
+}
+
+/*
+ * The energy carrier detectors.  The Goertzel window sets the width of the
+ * bins: 88 samples gives 300Hz bins for the 1200 baud tones; the 300 baud
+ * tones are only 200Hz apart and use 100Hz bins (see EnergyDcd).
+ */
+typedef mobilinkd::tnc::EnergyDcd<ADC_BUFFER_SIZE, 88> afsk1200_energy_dcd_type;
+typedef mobilinkd::tnc::EnergyDcd<ADC_BUFFER_SIZE, 264> afsk300_energy_dcd_type;
+
 q15_t normalized[ADC_BUFFER_SIZE];
 
+DemodulatorStats demodulator_stats;
+
+const DemodulatorStats& demodulatorStats()
+{
+    return demodulator_stats;
+}
+
+duplicate_filter_type& duplicateFilter()
+{
+    static duplicate_filter_type instance(DUPLICATE_WINDOW);
+    return instance;
+}
+
+void DemodulatorStats::reset()
+{
+    blocks = 0;
+    frames = 0;
+    unique = 0;
+    dropped = 0;
+    cycles.reset();
+    fix_bits = hdlc::FixBitsStats();
+    carriers = 0;
+    locks = 0;
+    early = 0;
+    lead = 0;
+}
+
+void DemodulatorStats::log() const
+{
+    INFO("demod: %lu blocks, %lu frames, %lu unique, %lu dropped",
+        blocks, frames, unique, dropped);
+    INFO("demod: cycles/block min = %lu, avg = %lu, max = %lu (%luus avg)",
+        cycles.min(), cycles.average(), cycles.max(),
+        cycles.average() / (SystemCoreClock / 1000000));
+    INFO("demod: fix bits single = %lu, adjacent = %lu, rejected = %lu, "
+        "failed = %lu, skipped = %lu", fix_bits.single, fix_bits.adjacent,
+        fix_bits.rejected, fix_bits.failed, fix_bits.skipped);
+    INFO("demod: duplicates = %lu, new = %lu",
+        duplicateFilter().hits(), duplicateFilter().misses());
+    INFO("demod: ADC overruns = %lu, drops = %lu",
+        adc_ring.overruns(), adc_ring.drops());
+    INFO("demod: DCD carriers = %lu, locks = %lu, early = %lu, lead = %lums avg",
+        carriers, locks, early, early ? uint32_t(uint64_t(lead) * ADC_BUFFER_SIZE
+            * 1000 / SAMPLE_RATE / early) : 0);
+}
+
+/// The fix bits mode from the KISS options.
+hdlc::FixBits fixBitsMode()
+{
+    auto options = kiss::settings().options;
+    return options & KISS_OPTION_FIX_BIT_PAIRS ? hdlc::FixBits::ADJACENT :
+        options & KISS_OPTION_FIX_BITS ? hdlc::FixBits::SINGLE : hdlc::FixBits::NONE;
+}
+
+/**
+ * Send a decoded frame to the IO event task unless it is a duplicate.
+ * Takes ownership of the frame.
+ */
+void forwardFrame(hdlc::IoFrame* received)
+{
+    auto& stats = demodulator_stats;
+    auto& duplicates = duplicateFilter();
+
+    ++stats.frames;
+    auto key = duplicate_filter_type::key(received->fcs(), received->size());
+    auto now = osKernelSysTick();
+    if (not duplicates(key, now)) {
+        if (osMessagePut(ioEventQueueHandle, (uint32_t) received, 1) == osOK) {
+            duplicates.add(key, now);
+            ++stats.unique;
+        } else {
+            ++stats.dropped;
+            hdlc::release(received);
+        }
+    }
+    else {
+        hdlc::release(received);
+    }
+}
+
+/**
+ * This provides 100Hz resolution to the Goerztel filter.
+ */
+constexpr uint32_t TWIST_SAMPLE_SIZE = 88;
+
+static_assert(ADC_BUFFER_SIZE % TWIST_SAMPLE_SIZE == 0,
+    "ADC_BUFFER_SIZE must be a multiple of TWIST_SAMPLE_SIZE");
+
+/// Send Vpp, Vavg, Vmin, Vmax as four 16-bit values, left justified.
+void sendInputLevels(uint16_t Vpp, uint16_t Vavg, uint16_t Vmin, uint16_t Vmax)
+{
+    Vpp <<= (16 - ADC_BITS);
+    Vavg <<= (16 - ADC_BITS);
+    Vmin <<= (16 - ADC_BITS);
+    Vmax <<= (16 - ADC_BITS);
+
+    uint8_t data[9];
+    data[0] = kiss::hardware::POLL_INPUT_LEVEL;
+    data[1] = (Vpp >> 8) & 0xFF;   // Vpp
+    data[2] = (Vpp & 0xFF);
+    data[3] = (Vavg >> 8) & 0xFF;  // Vavg (DC level)
+    data[4] = (Vavg & 0xFF);
+    data[5] = (Vmin >> 8) & 0xFF;  // Vmin
+    data[6] = (Vmin & 0xFF);
+    data[7] = (Vmax >> 8) & 0xFF;  // Vmax
+    data[8] = (Vmax & 0xFF);
+
+    ioport->write(data, 9, 6, 10);
+}
+
+/// Send the mark and space levels in dB, as 8.8 fixed point.
+void sendInputTwist(float g1200, float g2200)
+{
+    int16_t g1200i = int16_t(g1200 * 256);
+    int16_t g2200i = int16_t(g2200 * 256);
+
+    uint8_t buffer[5];
+    buffer[0] = kiss::hardware::POLL_INPUT_TWIST;
+    buffer[1] = (g1200i >> 8) & 0xFF;
+    buffer[2] = g1200i & 0xFF;
+    buffer[3] = (g2200i >> 8) & 0xFF;
+    buffer[4] = g2200i & 0xFF;
+
+    ioport->write(buffer, 5, 6, 10);
+}
+
+typedef InputMonitor<TWIST_SAMPLE_SIZE, SAMPLE_RATE> input_monitor_type;
+typedef InputTracker<vref> input_tracker_type;
+
+input_monitor_type input_monitor;
+
+/*
+ * The live input polls.  The IO task sets a request bit; the demodulator
+ * answers it from input_monitor, or with what it has when it stops.  The
+ * levels are answered after the next block.  The twist is measured only
+ * once asked for, and is answered when the measurement is complete.  The
+ * IO task takes the request back when the monitor cannot answer it,
+ * either because no demodulator is running or because the ADC is not at
+ * the AFSK sample rate (for the twist).
+ */
+constexpr uint32_t LIVE_INPUT_LEVEL = 1;
+constexpr uint32_t LIVE_INPUT_TWIST = 2;
+
+std::atomic<uint32_t> live_input_available{0};    ///< Requests it can answer.
+std::atomic<uint32_t> live_input_requests{0};
+
+bool pollLiveInput(uint8_t cmd)
+{
+    uint32_t request = 0;
+    switch (cmd) {
+    case kiss::hardware::POLL_INPUT_LEVEL:
+        request = LIVE_INPUT_LEVEL;
+        break;
+    case kiss::hardware::POLL_INPUT_TWIST:
+        request = LIVE_INPUT_TWIST;
+        break;
+    default:
+        return false;
+    }
+
+    live_input_requests.fetch_or(request);
+    if (live_input_available & request) return true;
+
+    // Answered already if the demodulator cleared the request.
+    return not (live_input_requests.fetch_and(~request) & request);
+}
+
+void answerLiveInput(uint32_t requests)
+{
+    if (requests & LIVE_INPUT_LEVEL) {
+        auto& levels = input_monitor.levels();
+        DEBUG("live levels: rms = %hu", levels.rms());
+        sendInputLevels(levels.pp(), levels.avg(), levels.min(), levels.max());
+    }
+    if (requests & LIVE_INPUT_TWIST) {
+        DEBUG("live twist: MARK=%d, SPACE=%d (x100)",
+            int(input_monitor.mark() * 100), int(input_monitor.space() * 100));
+        sendInputTwist(input_monitor.mark(), input_monitor.space());
+        input_monitor.stop_twist();
+    }
+}
+
+input_tracker_type input_tracker;
+
+/**
+ * Update the virtual ground from the tracker, and change the input gain
+ * if it recommends a change and no carrier is present.  Only the hardware
+ * gain changes; the saved input gain setting is left as the user set it.
+ *
+ * The op amp is stopped while its gain and DC offset are changed, so the
+ * ADC is stopped around it and the ring is started again.  No block then
+ * holds samples taken across the change.  The rest of the current half of
+ * the ring is dropped; there is no carrier to lose.  The virtual ground
+ * keeps its old value until the tracker has seen a settled window.
+ */
+void trackInput()
+{
+    int step = input_tracker(input_monitor.levels(), dcd());
+
+    auto ground = input_tracker.ground();
+    if (ground != virtual_ground) {
+        virtual_ground = ground;
+        i_vgnd = 1.0 / virtual_ground;
+    }
+
+    if (step == 0 or dcd()) return;
+
+    int gain = input_tracker.gain() + step;
+#if AUTO_INPUT_GAIN
+    INFO("input gain: %d -> %d (%s)", input_tracker.gain(), gain,
+        step < 0 ? "clipping" : "low level");
+    stopADC();
+    set_input_gain(gain);
+    restartADC();
+    input_tracker.set_gain(gain);
+#else
+    INFO("input gain: %d recommended (%s)", gain,
+        step < 0 ? "clipping" : "low level");
+    input_tracker.set_gain(input_tracker.gain());
+#endif
+}
+
+/**
+ * Start measuring the input from the demodulator's blocks.
+ *
+ * @param twist is false if the ADC is not at the AFSK sample rate.
+ */
+void startInputMonitor(bool twist)
+{
+    input_monitor.reset(twist);
+    input_tracker.reset(virtual_ground, input_gain());
+    live_input_available = LIVE_INPUT_LEVEL | (twist ? LIVE_INPUT_TWIST : 0);
+}
+
+/**
+ * Add a raw ADC block to the input monitor, track the input, and answer
+ * any live polls that it has the measurements for.  The twist is only
+ * measured while it is asked for, on blocks without DCD.
+ */
+void updateInputMonitor(const uint16_t* block)
+{
+    uint32_t requests = live_input_requests.load(std::memory_order_relaxed);
+    if (requests & LIVE_INPUT_TWIST) input_monitor.start_twist();
+
+    if (input_monitor(block, ADC_BUFFER_SIZE, dcd())) trackInput();
+
+    if (requests) {
+        uint32_t ready = live_input_available & LIVE_INPUT_LEVEL;
+        if (input_monitor.twist_complete()) ready |= LIVE_INPUT_TWIST;
+        answerLiveInput(live_input_requests.fetch_and(~ready) & ready);
+    }
+}
+
+void stopInputMonitor()
+{
+    uint32_t available = live_input_available.exchange(0);
+    answerLiveInput(live_input_requests.fetch_and(~available) & available);
+}
+
+/**
+ * Drive DCD from the energy detector and the demodulator lock.  DCD is
+ * on while either one is on, so that CSMA sees a carrier as soon as the
+ * energy detector does.  Records how far the energy detector is ahead of
+ * the lock in the demodulator statistics.
+ */
+struct CarrierDetect
+{
+    bool carrier{false};
+    bool locked{false};
+    uint32_t carrier_block{0};
+
+    void operator()(bool new_carrier, bool new_locked)
+    {
+        auto& stats = demodulator_stats;
+        bool was_on = carrier or locked;
+
+        if (new_carrier and not carrier) {
+            ++stats.carriers;
+            carrier_block = stats.blocks;
+        }
+        if (new_locked and not locked) {
+            ++stats.locks;
+            if (carrier or new_carrier) {
+                ++stats.early;
+                stats.lead += stats.blocks - carrier_block;
+            }
+        }
+
+        carrier = new_carrier;
+        locked = new_locked;
+
+        bool is_on = carrier or locked;
+        if (is_on != was_on) {
+            if (is_on) {
+                dcd_on();
+            } else {
+                dcd_off();
+            }
+        }
+    }
+};
+
+/**
+ * Run one of the demodulators that have no twist adjustment until the
+ * audio input task is given a new state.
+ *
+ * @param demod is the demodulator, already initialized.
+ * @param modem provides the ADC sample rate and block size.
+ * @param filter is true to band-pass filter the input for AFSK.
+ * @param energy_dcd is the energy carrier detector for the modem's
+ *  tones, or nullptr to use only the demodulator lock for DCD.
+ */
+template <typename Demodulator, typename EnergyDetector = afsk300_energy_dcd_type>
+void runDemodulator(Demodulator& demod, const Modem& modem, bool filter,
+    EnergyDetector* energy_dcd = nullptr)
+{
+    if (filter) audio_filter.init(bpf_coeffs.data());
+
+    demod.fix_bits(fixBitsMode());
+
+    startADC(AUDIO_IN, modem.adc_sample_rate);
+
+    // The twist measurement needs the AFSK sample rate.
+    startInputMonitor(modem.adc_sample_rate == SAMPLE_RATE);
+
+    CarrierDetect carrier_detect;
+
+    auto& stats = demodulator_stats;
+    stats.reset();
+    CycleCounter::enable();
+    duplicateFilter().reset();
+
+    while (true) {
+        osEvent peek = osMessagePeek(audioInputQueueHandle, 0);
+        if (peek.status == osEventMessage) break;
+
+        auto block = adc_ring.acquire();
+        if (!block) continue;
+
+        stats.cycles.start();
+
+        auto samples = (int16_t*) block;
+
+        arm_offset_q15(samples, 0 - virtual_ground, normalized, ADC_BUFFER_SIZE);
+        updateInputMonitor(block);
+        adc_ring.release();
+        bool carrier = energy_dcd and (*energy_dcd)(normalized);
+        q15_t* audio = filter ? audio_filter(normalized) : normalized;
+
+        for (auto frame : demod(audio, modem.adc_block_size)) {
+            if (frame) forwardFrame(frame);
+        }
+
+        carrier_detect(carrier, demod.locked());
+
+        stats.cycles.stop();
+        if (++stats.blocks % STATS_INTERVAL == 0) {
+            stats.fix_bits = demod.fix_bits_stats();
+            stats.log();
+        }
+    }
+
+    stopInputMonitor();
+    stopADC();
+    dcd_off();
+    stats.fix_bits = demod.fix_bits_stats();
+    stats.log();
+}
+
+/**
+ * The 300 baud HF demodulator.  The input is band-pass filtered as for
+ * 1200 baud AFSK; the tones are well inside the pass band.
+ */
+void afsk300DemodulatorTask(const Modem& modem) {
+
+    DEBUG("enter afsk300DemodulatorTask");
+
+    auto& demod = getAfsk300Demodulator();
+    demod.init();
+    afsk300_energy_dcd_type energy_dcd(afsk300::MARK_FREQ, afsk300::SPACE_FREQ,
+        1000, 2400);
+    runDemodulator(demod, modem, true, &energy_dcd);
+
+    DEBUG("exit afsk300DemodulatorTask");
+}
+
+/**
+ * The G3RUH 9600 baud demodulator.  The ADC runs at fsk9600::SAMPLE_RATE
+ * and the input is not band-pass filtered.
+ */
+void fsk9600DemodulatorTask(const Modem& modem) {
+
+    DEBUG("enter fsk9600DemodulatorTask");
+
+    runDemodulator(getFsk9600Demodulator(), modem, false);
+
+    DEBUG("exit fsk9600DemodulatorTask");
+}
+
 void demodulatorTask() {
 
-    DEBUG("enter demodulatorTask");
+    const auto& modem = currentModem();
+    INFO("modem: %s, ADC %luHz, DAC %luHz", modem.name,
+        modem.adc_sample_rate, modem.dac_sample_rate);
+    modem.demodulate(modem);
+}
+
+/**
+ * The 1200 baud AFSK demodulator.  The branches follow the twist of the
+ * received signal when AFSK_ADAPTIVE_TWIST is set.
+ */
+void afsk1200DemodulatorTask(const Modem& modem) {
+
+    DEBUG("enter afsk1200DemodulatorTask");
 
-    audio_filter.init(bpf_coeffs);
+    audio_filter.init(bpf_coeffs.data());
 
     // rx_twist is 6dB for discriminator input and 0db for de-emphasized input.
     auto twist = kiss::settings().rx_twist;
 
-    mobilinkd::tnc::afsk1200::Demodulator& demod1 = getDemod1(*filter::fir::AfskFilters[twist + 3]);
-    mobilinkd::tnc::afsk1200::Demodulator& demod2 = getDemod2(*filter::fir::AfskFilters[twist + 6]);
-    mobilinkd::tnc::afsk1200::Demodulator& demod3 = getDemod3(*filter::fir::AfskFilters[twist + 9]);
+    // The branches are spaced 3dB apart, centered on rx_twist.
+    demodulator_type& demod = getDemodulator();
+    AdaptiveTwist<demodulator_type::size()> adaptive_twist(twist);
+    for (size_t i = 0; i != demod.size(); ++i) {
+#if AFSK_CORRELATOR
+        demod.init(i, adaptive_twist[i]);
+#else
+        demod.init(i, *filter::fir::AfskFixedFilters[adaptive_twist[i] + 6]);
+#endif
+    }
 
-    startADC(AUDIO_IN);
+    demod.fix_bits(fixBitsMode());
 
-    mobilinkd::tnc::hdlc::IoFrame* frame = 0;
+    startADC(AUDIO_IN, modem.adc_sample_rate);
+    startInputMonitor(true);
 
-    uint16_t last_fcs = 0;
-    uint32_t last_counter = 0;
-    uint32_t counter = 0;
+    afsk1200_energy_dcd_type energy_dcd(1200, 2200, 600, 3300);
+    CarrierDetect carrier_detect;
 
-    bool dcd_status{false};
+    auto& stats = demodulator_stats;
+    stats.reset();
+    CycleCounter::enable();
+
+    duplicateFilter().reset();
 
     while (true) {
         osEvent peek = osMessagePeek(audioInputQueueHandle, 0);
         if (peek.status == osEventMessage) break;
 
-        osEvent evt = osMessageGet(adcInputQueueHandle, osWaitForever);
-        if (evt.status != osEventMessage) {
-            continue;
-        }
+        auto block = adc_ring.acquire();
+        if (!block) continue;
 
-        ++counter;
+        stats.cycles.start();
 
-        auto block = (adc_pool_type::chunk_type*) evt.value.p;
-        auto samples = (int16_t*) block->buffer;
+        auto samples = (int16_t*) block;
 
         arm_offset_q15(samples, 0 - virtual_ground, normalized, ADC_BUFFER_SIZE);
-        adcPool.deallocate(block);
+        updateInputMonitor(block);
+        adc_ring.release();
+        bool carrier = energy_dcd(normalized);
         q15_t* audio = audio_filter(normalized);
 
-#if 1
-        frame = demod1(audio, ADC_BUFFER_SIZE);
-        if (frame) {
-            if (frame->fcs() != last_fcs or counter > last_counter + 2) {
-                auto save_fcs = frame->fcs();
-                if (osMessagePut(ioEventQueueHandle, (uint32_t) frame, 1) == osOK) {
-                  last_fcs = save_fcs;
-                  last_counter = counter;
-                } else {
-                  hdlc::release(frame);
-                }
-            }
-            else {
-                hdlc::release(frame);
-            }
-        }
+        auto frames = demod(audio, modem.adc_block_size);
+        for (size_t i = 0; i != frames.size(); ++i) {
+            if (not frames[i]) continue;
+#if AFSK_ADAPTIVE_TWIST
+            adaptive_twist(i, duplicate_filter_type::key(
+                frames[i]->fcs(), frames[i]->size()));
 #endif
-
-#if 1
-        frame = demod2(audio, ADC_BUFFER_SIZE);
-        if (frame) {
-          if (frame->fcs() != last_fcs or counter > last_counter + 2) {
-              auto save_fcs = frame->fcs();
-              if (osMessagePut(ioEventQueueHandle, (uint32_t) frame, 1) == osOK) {
-                last_fcs = save_fcs;
-                last_counter = counter;
-              } else {
-                hdlc::release(frame);
-              }
-          }
-          else {
-              hdlc::release(frame);
-          }
+            forwardFrame(frames[i]);
         }
-#endif
 
-#if 1
-        frame = demod3(audio, ADC_BUFFER_SIZE);
-        if (frame) {
-          if (frame->fcs() != last_fcs or counter > last_counter + 2) {
-              auto save_fcs = frame->fcs();
-              if (osMessagePut(ioEventQueueHandle, (uint32_t) frame, 1) == osOK) {
-                last_fcs = save_fcs;
-                last_counter = counter;
-              } else {
-                hdlc::release(frame);
-              }
-          }
-          else {
-              hdlc::release(frame);
-          }
-        }
-#endif
-        bool new_dcd_status = demod1.locked() or demod2.locked() or demod3.locked();
-        if (new_dcd_status xor dcd_status) {
-            dcd_status = new_dcd_status;
-            if (dcd_status) {
-                dcd_on();
-            } else {
-                dcd_off();
+        bool locked = demod.locked();
+
+        // Only change the filters between frames.
+        if (adaptive_twist.changed() and not locked) {
+            for (size_t i = 0; i != demod.size(); ++i) {
+                setBranchTwist(demod, i, adaptive_twist[i]);
             }
+            adaptive_twist.applied();
+            INFO("demod: twist = %ddB", adaptive_twist.center());
+        }
+        carrier_detect(carrier, locked);
+
+        stats.cycles.stop();
+        if (++stats.blocks % STATS_INTERVAL == 0) {
+            stats.fix_bits = demod.fix_bits_stats();
+            stats.log();
         }
     }
 
+    stopInputMonitor();
     stopADC();
     dcd_off();
-    DEBUG("exit demodulatorTask");
+    stats.fix_bits = demod.fix_bits_stats();
+    stats.log();
+    DEBUG("exit afsk1200DemodulatorTask");
 }
 
 
@@ -323,32 +688,21 @@ void streamLevels(uint32_t channel, uint8_t cmd) {
         osEvent peek = osMessagePeek(audioInputQueueHandle, 0);
         if (peek.status == osEventMessage) break;
 
-        uint16_t count = 0;
-        uint32_t accum = 0;
-        uint16_t vmin = std::numeric_limits<uint16_t>::max();
-        uint16_t vmax = std::numeric_limits<uint16_t>::min();
-
-        while (count < 2640) {
-            osEvent evt = osMessageGet(adcInputQueueHandle, osWaitForever);
-            if (evt.status != osEventMessage) continue;
+        LevelMeter meter;
 
-            count += ADC_BUFFER_SIZE;
+        while (meter.count() < 2640) {
+            auto block = adc_ring.acquire();
+            if (!block) continue;
 
-            auto block = (adc_pool_type::chunk_type*) evt.value.p;
-            auto start =  (uint16_t*) block->buffer;
-            auto end = start + ADC_BUFFER_SIZE;
+            meter(block, ADC_BUFFER_SIZE);
 
-            vmin = std::min(vmin, *std::min_element(start, end));
-            vmax = std::max(vmax, *std::max_element(start, end));
-            accum = std::accumulate(start, end, accum);
-
-            adcPool.deallocate(block);
+            adc_ring.release();
         }
 
-        uint16_t pp = (vmax - vmin) << 4;
-        uint16_t avg = (accum / count) << 4;
-        vmin <<= 4;
-        vmax <<= 4;
+        uint16_t pp = meter.pp() << (16 - ADC_BITS);
+        uint16_t avg = meter.avg() << (16 - ADC_BITS);
+        uint16_t vmin = meter.min() << (16 - ADC_BITS);
+        uint16_t vmax = meter.max() << (16 - ADC_BITS);
 
         data[0] = cmd;
         data[1] = (pp >> 8) & 0xFF;   // Vpp
@@ -373,46 +727,54 @@ levels_type readLevels(uint32_t channel, uint32_t samples) {
 
     // Return Vpp, Vavg, Vmin, Vmax as four 16-bit values, right justified.
 
-    uint16_t count = 0;
-    uint32_t accum = 0;
-    uint16_t vmin = std::numeric_limits<uint16_t>::max();
-    uint16_t vmax = std::numeric_limits<uint16_t>::min();
+    LevelMeter meter;
 
     INFO("readLevels: start");
     startADC(channel);
 
-    while (count < samples) {
-
-        osEvent evt = osMessageGet(adcInputQueueHandle, osWaitForever);
-        if (evt.status != osEventMessage) continue;
+    while (meter.count() < samples) {
 
-        auto block = (adc_pool_type::chunk_type*) evt.value.p;
-        auto start =  (uint16_t*) block->buffer;
-        auto end = start + ADC_BUFFER_SIZE;
+        auto block = adc_ring.acquire();
+        if (!block) continue;
 
-        vmin = std::min(vmin, *std::min_element(start, end));
-        vmax = std::max(vmax, *std::max_element(start, end));
-        accum = std::accumulate(start, end, accum);
+        meter(block, ADC_BUFFER_SIZE);
 
-        adcPool.deallocate(block);
-
-        count += ADC_BUFFER_SIZE;
+        adc_ring.release();
     }
 
     stopADC();
 
-    uint16_t pp = vmax - vmin;
-    uint16_t avg = accum / count;
-    DEBUG("exit readLevels");
+    DEBUG("exit readLevels (rms = %hu)", meter.rms());
 
-    return levels_type(pp, avg, vmin, vmax);
+    return levels_type(meter.pp(), meter.avg(), meter.min(), meter.max());
 }
 
 
 /**
- * This provides 100Hz resolution to the Goerztel filter.
+ * Read the ADC ring N samples at a time.  Each ADC block is split into
+ * ADC_BUFFER_SIZE / N pieces; the block is released after the last one.
+ * This keeps the Goertzel filters at N samples whatever the block size.
  */
-constexpr uint32_t TWIST_SAMPLE_SIZE = 88;
+template <size_t N>
+struct AdcReader
+{
+    size_t offset_{0};
+
+    const uint16_t* acquire()
+    {
+        auto block = adc_ring.acquire();
+        return block ? block + offset_ : nullptr;
+    }
+
+    void release()
+    {
+        offset_ += N;
+        if (offset_ == ADC_BUFFER_SIZE) {
+            offset_ = 0;
+            adc_ring.release();
+        }
+    }
+};
 
 /*
  * Return twist as a the difference in dB between mark and space.  The
@@ -428,36 +790,32 @@ float readTwist()
   float g1200 = 0.0f;
   float g2200 = 0.0f;
 
-  GoertzelFilter<TWIST_SAMPLE_SIZE, SAMPLE_RATE> gf1200(1200.0, 0);
-  GoertzelFilter<TWIST_SAMPLE_SIZE, SAMPLE_RATE> gf2200(2200.0, 0);
+  GoertzelBank<2, TWIST_SAMPLE_SIZE, SAMPLE_RATE> gf({1200.0, 2200.0}, 0);
 
   const uint32_t AVG_SAMPLES = 20;
 
   startADC(channel);
 
+  AdcReader<TWIST_SAMPLE_SIZE> reader;
+
   for (uint32_t i = 0; i != AVG_SAMPLES; ++i)
   {
     uint32_t count = 0;
     while (count < TWIST_SAMPLE_SIZE)
     {
-        osEvent evt = osMessageGet(adcInputQueueHandle, osWaitForever);
-        if (evt.status != osEventMessage) continue;
-
-        auto block = (adc_pool_type::chunk_type*) evt.value.p;
-        uint16_t* data =  (uint16_t*) block->buffer;
-        gf1200(data, ADC_BUFFER_SIZE);
-        gf2200(data, ADC_BUFFER_SIZE);
+        auto block = reader.acquire();
+        if (!block) continue;
+        gf(block, TWIST_SAMPLE_SIZE);
 
-        adcPool.deallocate(block);
+        reader.release();
 
-        count += ADC_BUFFER_SIZE;
+        count += TWIST_SAMPLE_SIZE;
     }
 
-    g1200 += (gf1200 / count);
-    g2200 += (gf2200 / count);
+    g1200 += (gf[0] / count);
+    g2200 += (gf[1] / count);
 
-    gf1200.reset();
-    gf2200.reset();
+    gf.reset();
   }
 
   stopADC();
@@ -502,36 +860,32 @@ void pollInputTwist()
     float g1200 = 0.0f;
     float g2200 = 0.0f;
 
-    GoertzelFilter<TWIST_SAMPLE_SIZE, SAMPLE_RATE> gf1200(1200.0);
-    GoertzelFilter<TWIST_SAMPLE_SIZE, SAMPLE_RATE> gf2200(2200.0);
+    GoertzelBank<2, TWIST_SAMPLE_SIZE, SAMPLE_RATE> gf({1200.0, 2200.0});
 
     const uint32_t AVG_SAMPLES = 100;
 
     startADC(channel);
 
+    AdcReader<TWIST_SAMPLE_SIZE> reader;
+
     for (uint32_t i = 0; i != AVG_SAMPLES; ++i) {
 
       uint32_t count = 0;
       while (count < TWIST_SAMPLE_SIZE) {
 
-          osEvent evt = osMessageGet(adcInputQueueHandle, osWaitForever);
-          if (evt.status != osEventMessage) continue;
-
-          count += ADC_BUFFER_SIZE;
+          auto block = reader.acquire();
+          if (!block) continue;
 
-          auto block = (adc_pool_type::chunk_type*) evt.value.p;
-          uint16_t* data =  (uint16_t*) block->buffer;
-          gf1200(data, ADC_BUFFER_SIZE);
-          gf2200(data, ADC_BUFFER_SIZE);
+          count += TWIST_SAMPLE_SIZE;
+          gf(block, TWIST_SAMPLE_SIZE);
 
-          adcPool.deallocate(block);
+          reader.release();
       }
 
-      g1200 += 10.0 * log10(gf1200);
-      g2200 += 10.0 * log10(gf2200);
+      g1200 += 10.0 * log10(gf[0]);
+      g2200 += 10.0 * log10(gf[1]);
 
-      gf1200.reset();
-      gf2200.reset();
+      gf.reset();
     }
 
     stopADC();
@@ -539,17 +893,7 @@ void pollInputTwist()
     DEBUG("pollInputTwist: MARK=%d, SPACE=%d (x100)",
       int(g1200 * 100.0 / AVG_SAMPLES), int(g2200 * 100.0 / AVG_SAMPLES));
 
-    int16_t g1200i = int16_t(g1200 * 256 / AVG_SAMPLES);
-    int16_t g2200i = int16_t(g2200 * 256 / AVG_SAMPLES);
-
-    uint8_t buffer[5];
-    buffer[0] = kiss::hardware::POLL_INPUT_TWIST;
-    buffer[1] = (g1200i >> 8) & 0xFF;
-    buffer[2] = g1200i & 0xFF;
-    buffer[3] = (g2200i >> 8) & 0xFF;
-    buffer[4] = g2200i & 0xFF;
-
-    ioport->write(buffer, 5, 6, 10);
+    sendInputTwist(g1200 / AVG_SAMPLES, g2200 / AVG_SAMPLES);
 
     DEBUG("exit pollInputTwist");
 }
@@ -563,6 +907,8 @@ void streamAverageInputTwist()
 
     startADC(channel);
 
+    AdcReader<TWIST_SAMPLE_SIZE> reader;
+
     uint32_t acount = 0;
     float g700 = 0.0f;
     float g1200 = 0.0f;
@@ -570,11 +916,8 @@ void streamAverageInputTwist()
     float g2200 = 0.0f;
     float g2700 = 0.0f;
 
-    GoertzelFilter<TWIST_SAMPLE_SIZE, 26400> gf700(700.0);
-    GoertzelFilter<TWIST_SAMPLE_SIZE, 26400> gf1200(1200.0);
-    GoertzelFilter<TWIST_SAMPLE_SIZE, 26400> gf1700(1700.0);
-    GoertzelFilter<TWIST_SAMPLE_SIZE, 26400> gf2200(2200.0);
-    GoertzelFilter<TWIST_SAMPLE_SIZE, 26400> gf2700(2700.0);
+    GoertzelBank<5, TWIST_SAMPLE_SIZE, 26400> gf(
+        {700.0, 1200.0, 1700.0, 2200.0, 2700.0});
 
     while (true) {
       osEvent peek = osMessagePeek(audioInputQueueHandle, 0);
@@ -584,27 +927,20 @@ void streamAverageInputTwist()
       uint32_t count = 0;
       while (count < TWIST_SAMPLE_SIZE) {
 
-          osEvent evt = osMessageGet(adcInputQueueHandle, osWaitForever);
-          if (evt.status != osEventMessage) continue;
+          auto block = reader.acquire();
+          if (!block) continue;
 
-          count += ADC_BUFFER_SIZE;
+          count += TWIST_SAMPLE_SIZE;
+          gf(block, TWIST_SAMPLE_SIZE);
 
-          auto block = (adc_pool_type::chunk_type*) evt.value.v;
-          uint16_t* data =  (uint16_t*) block->buffer;
-          gf700(data, ADC_BUFFER_SIZE);
-          gf1200(data, ADC_BUFFER_SIZE);
-          gf1700(data, ADC_BUFFER_SIZE);
-          gf2200(data, ADC_BUFFER_SIZE);
-          gf2700(data, ADC_BUFFER_SIZE);
-
-          adcPool.deallocate(block);
+          reader.release();
       }
 
-      g700 += 10.0 * log10(gf700);
-      g1200 += 10.0 * log10(gf1200);
-      g1700 += 10.0 * log10(gf1700);
-      g2200 += 10.0 * log10(gf2200);
-      g2700 += 10.0 * log10(gf2700);
+      g700 += 10.0 * log10(gf[0]);
+      g1200 += 10.0 * log10(gf[1]);
+      g1700 += 10.0 * log10(gf[2]);
+      g2200 += 10.0 * log10(gf[3]);
+      g2700 += 10.0 * log10(gf[4]);
 
       char* buffer = 0;
       // @TODO: Make re-entrant printf work (or convert to fixed-point).
@@ -623,11 +959,7 @@ void streamAverageInputTwist()
         free(buffer);
       }
 
-      gf700.reset();
-      gf1200.reset();
-      gf1700.reset();
-      gf2200.reset();
-      gf2700.reset();
+      gf.reset();
     }
 
     stopADC();
@@ -642,11 +974,10 @@ void streamInstantInputTwist()
 
     startADC(channel);
 
-    GoertzelFilter<TWIST_SAMPLE_SIZE, 26400> gf700(700.0);
-    GoertzelFilter<TWIST_SAMPLE_SIZE, 26400> gf1200(1200.0);
-    GoertzelFilter<TWIST_SAMPLE_SIZE, 26400> gf1700(1700.0);
-    GoertzelFilter<TWIST_SAMPLE_SIZE, 26400> gf2200(2200.0);
-    GoertzelFilter<TWIST_SAMPLE_SIZE, 26400> gf2700(2700.0);
+    AdcReader<TWIST_SAMPLE_SIZE> reader;
+
+    GoertzelBank<5, TWIST_SAMPLE_SIZE, 26400> gf(
+        {700.0, 1200.0, 1700.0, 2200.0, 2700.0});
 
     while (true) {
       osEvent peek = osMessagePeek(audioInputQueueHandle, 0);
@@ -655,20 +986,13 @@ void streamInstantInputTwist()
       uint32_t count = 0;
       while (count < TWIST_SAMPLE_SIZE) {
 
-          osEvent evt = osMessageGet(adcInputQueueHandle, osWaitForever);
-          if (evt.status != osEventMessage) continue;
+          auto block = reader.acquire();
+          if (!block) continue;
 
-          count += ADC_BUFFER_SIZE;
+          count += TWIST_SAMPLE_SIZE;
+          gf(block, TWIST_SAMPLE_SIZE);
 
-          auto block = (adc_pool_type::chunk_type*) evt.value.v;
-          uint16_t* data =  (uint16_t*) block->buffer;
-          gf700(data, ADC_BUFFER_SIZE);
-          gf1200(data, ADC_BUFFER_SIZE);
-          gf1700(data, ADC_BUFFER_SIZE);
-          gf2200(data, ADC_BUFFER_SIZE);
-          gf2700(data, ADC_BUFFER_SIZE);
-
-          adcPool.deallocate(block);
+          reader.release();
       }
 
       char* buffer = 0;
@@ -676,11 +1000,11 @@ void streamInstantInputTwist()
       int len = asiprintf_r(
         &buffer,
         "_%f, %f, %f, %f, %f\r\n",
-        10.0 * log10(gf700),
-        10.0 * log10(gf1200),
-        10.0 * log10(gf1700),
-        10.0 * log10(gf2200),
-        10.0 * log10(gf2700));
+        10.0 * log10(gf[0]),
+        10.0 * log10(gf[1]),
+        10.0 * log10(gf[2]),
+        10.0 * log10(gf[3]),
+        10.0 * log10(gf[4]));
 
       if (len > 0) {
         buffer[0] = kiss::hardware::POLL_INPUT_TWIST;
@@ -688,11 +1012,7 @@ void streamInstantInputTwist()
         free(buffer);
       }
 
-      gf700.reset();
-      gf1200.reset();
-      gf1700.reset();
-      gf2200.reset();
-      gf2700.reset();
+      gf.reset();
     }
 
     stopADC();
@@ -711,24 +1031,7 @@ void pollAmplifiedInputLevel() {
 
     uint16_t Vpp, Vavg, Vmin, Vmax;
     std::tie(Vpp, Vavg, Vmin, Vmax) = readLevels(AUDIO_IN);
-
-    Vpp <<= 4;
-    Vavg <<= 4;
-    Vmin <<= 4;
-    Vmax <<= 4;
-
-    uint8_t data[9];
-    data[0] = kiss::hardware::POLL_INPUT_LEVEL;
-    data[1] = (Vpp >> 8) & 0xFF;   // Vpp
-    data[2] = (Vpp & 0xFF);
-    data[3] = (Vavg >> 8) & 0xFF;  // Vavg (DC level)
-    data[4] = (Vavg & 0xFF);
-    data[5] = (Vmin >> 8) & 0xFF;  // Vmin
-    data[6] = (Vmin & 0xFF);
-    data[7] = (Vmax >> 8) & 0xFF;  // Vmax
-    data[8] = (Vmax & 0xFF);
-
-    ioport->write(data, 9, 6, 10);
+    sendInputLevels(Vpp, Vavg, Vmin, Vmax);
     DEBUG("exit pollAmplifiedInputLevel");
 }
 
@@ -748,6 +1051,7 @@ void pollBatteryLevel() {
 
     htim6.Init.Period = 48000;
     if (HAL_TIM_Base_Init(&htim6) != HAL_OK) CxxErrorHandler();
+    configureOversampling(4);   // 16 conversions of 260 cycles.
 
     if (HAL_TIM_Base_Start(&htim6) != HAL_OK)
         CxxErrorHandler();
@@ -782,7 +1086,8 @@ void pollBatteryLevel() {
     if (HAL_TIM_Base_Stop(&htim6) != HAL_OK)
         CxxErrorHandler();
 
-    htim6.Init.Period = 1817;
+    // Restore the audio sample period, as startADC() sets it.
+    htim6.Init.Period = SystemCoreClock / SAMPLE_RATE - 1;
     if (HAL_TIM_Base_Init(&htim6) != HAL_OK) CxxErrorHandler();
 
     HAL_Delay(1);
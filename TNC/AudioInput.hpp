@@ -7,6 +7,12 @@
 #include "main.h"
 #include "stm32l4xx_hal.h"
 #include "cmsis_os.h"
+#include "AdcRing.hpp"
+#include "AudioLevel.hpp"
+#include "CycleCounter.hpp"
+#include "DuplicateFilter.hpp"
+#include "FilterDesign.hpp"
+#include "HdlcDecoder.hpp"
 
 #include <tuple>
 #include <atomic>
@@ -62,7 +68,11 @@ void TNC_Error_Handler(int dev, int err);
 #ifdef __cplusplus
 }
 
-namespace mobilinkd { namespace tnc { namespace audio {
+namespace mobilinkd { namespace tnc {
+
+struct Modem;
+
+namespace audio {
 
 constexpr const uint32_t SAMPLE_RATE = 26400;
 
@@ -83,9 +93,139 @@ enum AdcState {
     STREAM_INSTANT_TWIST_LEVEL
 };
 
-const size_t ADC_BUFFER_SIZE = 88;
-const size_t DMA_TRANSFER_SIZE = ADC_BUFFER_SIZE / 2;
-extern uint32_t adc_buffer[];       // Two int16_t samples per element.
+/*
+ * The number of samples in each ADC block.  The demodulators, filters and
+ * the ADC DMA ring are all sized from this.  Larger blocks cost less per
+ * block (queue round trips, filter setup) and add latency.  It must be a
+ * multiple of 88 (the Goertzel twist measurements) and of AFSK_DECIMATION.
+ * 88 is 3.3ms at 26400Hz.
+ */
+#ifndef ADC_BLOCK_SIZE
+#define ADC_BLOCK_SIZE 88
+#endif
+
+const size_t ADC_BUFFER_SIZE = ADC_BLOCK_SIZE;
+
+/*
+ * The number of ADC_BUFFER_SIZE blocks in the ADC DMA ring (even).  The
+ * DMA interrupts when each half of the ring is full, so with 2 blocks each
+ * block is handed to the audio input task as soon as it is full, and DCD
+ * lags the audio by one block.  The task then has one block of time to
+ * finish with each block.  More blocks give it more time, but are handed
+ * over ADC_RING_BLOCKS / 2 at a time, which adds that many blocks to the
+ * DCD and CSMA latency.  The overruns and drops in the demodulator
+ * statistics show when the task falls behind.
+ */
+#ifndef ADC_RING_BLOCKS
+#define ADC_RING_BLOCKS 2
+#endif
+
+const size_t ADC_SLOT_COUNT = ADC_RING_BLOCKS;
+
+/*
+ * The AFSK demodulator decimates by this factor after the discriminator.
+ * The emphasis filters and the bit-packed discriminator run at the ADC
+ * sample rate; the low-pass filter only computes every DECIMATION'th
+ * output, and the PLL and HDLC decoder run at DEMOD_SAMPLE_RATE.
+ */
+#ifndef AFSK_DECIMATION
+#define AFSK_DECIMATION 1
+#endif
+
+static_assert(AFSK_DECIMATION >= 1 and ADC_BLOCK_SIZE % AFSK_DECIMATION == 0,
+    "AFSK_DECIMATION must divide ADC_BLOCK_SIZE (88 by default: 1, 2 or 4)");
+
+const size_t DECIMATION = AFSK_DECIMATION;
+constexpr const uint32_t DEMOD_SAMPLE_RATE = SAMPLE_RATE / DECIMATION;
+
+/*
+ * 1100-2350Hz bandpass, Hann window.  Designed with 152 taps; the near-zero
+ * taps at each end are removed.
+ *
+ * np.array(
+ *  firwin2(152,
+ *      [0.0, 1000.0, 1100.0, 2350.0, 2500.0, sample_rate/2],
+ *      [0,0,1,1,0,0],
+ *      fs=sample_rate,
+ *      window='hann') * 32768,
+ *  dtype=int)[10:-10]
+ */
+constexpr size_t FILTER_TAP_NUM = 132;
+constexpr auto bpf_coeffs = filter::design::truncate<q15_t, 15>(
+    filter::design::trim<10>(filter::design::firwin2<FILTER_TAP_NUM + 20>(
+        std::array<double, 6>{0.0, 1000.0, 1100.0, 2350.0, 2500.0, SAMPLE_RATE / 2.0},
+        std::array<double, 6>{0.0, 0.0, 1.0, 1.0, 0.0, 0.0},
+        SAMPLE_RATE, filter::design::Window::HANN)));
+
+static_assert(SAMPLE_RATE != 26400
+    or filter::design::fingerprint(bpf_coeffs) == 0xe102a8d7,
+    "bpf_coeffs does not match the scipy design");
+
+/*
+ * The AFSK 1200 demodulator engine.  0 is the delay-line discriminator
+ * (afsk1200::FusedDemodulator); 1 is the quadrature correlator
+ * (CorrelatorDemodulator), which decodes fewer packets for less CPU.
+ */
+#ifndef AFSK_CORRELATOR
+#define AFSK_CORRELATOR 0
+#endif
+
+/*
+ * Move the demodulator branches toward the twist that decodes the most
+ * frames while running (see AdaptiveTwist).  When 0 the branches stay
+ * centered on rx_twist.
+ */
+#ifndef AFSK_ADAPTIVE_TWIST
+#define AFSK_ADAPTIVE_TWIST 1
+#endif
+
+/*
+ * Change the input gain while receiving when the input clips or stays
+ * low (see InputTracker).  Changes are made between packets and apply
+ * to the hardware only; the input gain setting is not changed, and it is
+ * restored when the input levels are next configured.  When 0 the
+ * recommended changes are only logged.
+ */
+#ifndef AUTO_INPUT_GAIN
+#define AUTO_INPUT_GAIN 1
+#endif
+
+typedef AdcRing<ADC_BUFFER_SIZE, ADC_SLOT_COUNT> adc_ring_type;
+extern adc_ring_type adc_ring;
+
+constexpr uint32_t ADC_CLOCK = 48000000;            // PLLSAI1 R output.
+constexpr uint32_t ADC_CONVERSION_CYCLES = 25;      // 12.5 sample + 12.5 convert.
+
+/**
+ * Set up the ADC hardware oversampler.  Each trigger starts a burst of
+ * 2^log2_ratio conversions that is summed and shifted right to ADC_BITS.
+ * The output stays at ADC_BITS whatever the ratio, so virtual_ground and
+ * vref do not depend on it.  The ADC must be stopped.
+ */
+inline void configureOversampling(uint32_t log2_ratio)
+{
+    constexpr uint32_t EXTRA_BITS = ADC_BITS - 12;
+
+    // The sum must have at least ADC_BITS bits.
+    if (log2_ratio < EXTRA_BITS or log2_ratio < 1 or log2_ratio > 8)
+        CxxErrorHandler();
+
+    LL_ADC_ConfigOverSamplingRatioShift(hadc1.Instance,
+        (log2_ratio - 1) << ADC_CFGR2_OVSR_Pos,
+        (log2_ratio - EXTRA_BITS) << ADC_CFGR2_OVSS_Pos);
+}
+
+/**
+ * The largest oversampling ratio (log2, up to 256) whose burst fits in 90%
+ * of the sample period.  The longer burst averages out more ADC noise and
+ * acts as an integrate-and-dump anti-aliasing filter, with no CPU cost.
+ */
+constexpr uint32_t oversamplingRatio(uint32_t sample_rate, uint32_t log2_ratio = 1)
+{
+    return log2_ratio != 8 and (2u << log2_ratio) * ADC_CONVERSION_CYCLES
+        <= ADC_CLOCK / sample_rate * 9 / 10 ?
+        oversamplingRatio(sample_rate, log2_ratio + 1) : log2_ratio;
+}
 
 inline void stopADC() {
     if (HAL_ADC_Stop_DMA(&hadc1) != HAL_OK)
@@ -94,9 +234,18 @@ inline void stopADC() {
         CxxErrorHandler();
 }
 
-inline void startADC(uint32_t channel) {
+/**
+ * Start the ADC.
+ *
+ * @param channel is the ADC channel.
+ * @param sample_rate is the sample rate; TIM6 triggers the ADC.
+ */
+inline void startADC(uint32_t channel, uint32_t sample_rate = SAMPLE_RATE) {
     ADC_ChannelConfTypeDef sConfig;
 
+    __HAL_TIM_SET_AUTORELOAD(&htim6, SystemCoreClock / sample_rate - 1);
+    configureOversampling(oversamplingRatio(sample_rate));
+
     sConfig.Channel = channel;
     sConfig.Rank = ADC_REGULAR_RANK_1;
     sConfig.SingleDiff = ADC_SINGLE_ENDED;
@@ -106,25 +255,84 @@ inline void startADC(uint32_t channel) {
     if (HAL_ADC_ConfigChannel(&hadc1, &sConfig) != HAL_OK)
         CxxErrorHandler();
 
+    adc_ring.reset();
+
     if (HAL_TIM_Base_Start(&htim6) != HAL_OK)
         CxxErrorHandler();
-    if (HAL_ADC_Start_DMA(&hadc1, adc_buffer, ADC_BUFFER_SIZE * 2) != HAL_OK)
+    if (HAL_ADC_Start_DMA(&hadc1, adc_ring.buffer(), adc_ring_type::SIZE) != HAL_OK)
         CxxErrorHandler();
 }
 
 inline void restartADC() {
+    adc_ring.reset();
+
     if (HAL_TIM_Base_Start(&htim6) != HAL_OK)
         CxxErrorHandler();
-    if (HAL_ADC_Start_DMA(&hadc1, adc_buffer, ADC_BUFFER_SIZE * 2) != HAL_OK)
+    if (HAL_ADC_Start_DMA(&hadc1, adc_ring.buffer(), adc_ring_type::SIZE) != HAL_OK)
         CxxErrorHandler();
 }
 
+/**
+ * Receive statistics for the demodulator.  These are reset each time the
+ * demodulator is started and are logged every STATS_INTERVAL blocks.  The
+ * frame counts are also sent in reply to the GET_DEMOD_STATS KISS command.
+ *
+ * The cycle counts measure the CPU time spent per ADC block, from the
+ * DC offset adjustment through HDLC decoding and DCD.  This is the
+ * yardstick for changes to the demodulator.
+ */
+struct DemodulatorStats
+{
+    uint32_t blocks{0};     ///< ADC blocks processed.
+    uint32_t frames{0};     ///< Frames decoded by all demodulators.
+    uint32_t unique{0};     ///< Frames forwarded (duplicates removed).
+    uint32_t dropped{0};    ///< Frames dropped because the IO queue was full.
+    CycleCounter cycles;    ///< CPU cycles spent per block.
+    hdlc::FixBitsStats fix_bits;    ///< Updated by the demodulator before logging.
+    uint32_t carriers{0};   ///< Carriers detected by the energy DCD.
+    uint32_t locks{0};      ///< Times the demodulator locked.
+    uint32_t early{0};      ///< Locks with the energy DCD already on.
+    uint32_t lead{0};       ///< Blocks from energy DCD to lock, summed over early.
+
+    void reset();
+    void log() const;
+};
+
+constexpr uint32_t STATS_INTERVAL = 30 * SAMPLE_RATE / ADC_BUFFER_SIZE;   // About 30 seconds.
+
+const DemodulatorStats& demodulatorStats();
+
+/*
+ * Frames with the same FCS and length decoded within this many ms of each
+ * other are duplicates.  The shortest AX.25 frame takes about 125ms to
+ * send at 1200 baud.
+ */
+constexpr uint32_t DUPLICATE_WINDOW = 100;
+
+typedef DuplicateFilter<8> duplicate_filter_type;
+
+/// The duplicate filter used by the demodulator, for its hit/miss counts.
+duplicate_filter_type& duplicateFilter();
+
 /// Vpp, Vavg, Vmin, Vmax
 typedef std::tuple<uint16_t, uint16_t, uint16_t, uint16_t> levels_type;
 levels_type readLevels(uint32_t channel, uint32_t samples = 2640);
 float readTwist();
 
+/**
+ * Answer a POLL_INPUT_LEVEL or POLL_INPUT_TWIST request from the running
+ * demodulator's input statistics, without stopping it.
+ *
+ * @return false if the demodulator is not running (or cannot measure
+ *  the input); the ADC must then be switched to the measurement.
+ */
+bool pollLiveInput(uint8_t cmd);
+
+/// Run the demodulator of the configured modem (see currentModem()).
 void demodulatorTask();
+void afsk1200DemodulatorTask(const Modem& modem);
+void afsk300DemodulatorTask(const Modem& modem);
+void fsk9600DemodulatorTask(const Modem& modem);
 void streamRawInputLevels();
 void streamAmplifiedInputLevels();
 void pollAmplifiedInputLevel();
@@ -27,6 +27,15 @@ namespace mobilinkd { namespace tnc { namespace audio {
 uint16_t virtual_ground{0};
 float i_vgnd{0.0f};
 
+namespace {
+int current_input_gain{0};
+}
+
+int input_gain()
+{
+    return current_input_gain;
+}
+
 void set_input_gain(int level)
 {
     uint32_t dc_offset{};
@@ -39,6 +48,7 @@ void set_input_gain(int level)
 
     level = std::max(0, level);
     level = std::min(4, level);
+    current_input_gain = level;
 
     // Adjust configuration and, if PGA, gain.
     switch (level) {
@@ -20,15 +20,35 @@ extern osMessageQId audioInputQueueHandle;
 
 constexpr const uint32_t AUDIO_IN = ADC_CHANNEL_8;
 
+/*
+ * The resolution of the ADC samples, 12 to 14 bits.  The ADC converts 12
+ * bits; the hardware oversampler sums a burst of conversions for each
+ * sample and shifts the sum right to this many bits (see
+ * configureOversampling()).  At most 14 so that the samples, once the
+ * virtual ground is removed, stay within the input range of the filters
+ * that add pairs of samples before multiplying (Q15_PREADD_LIMIT).
+ */
+#ifndef ADC_SAMPLE_BITS
+#define ADC_SAMPLE_BITS 14
+#endif
+
+static_assert(ADC_SAMPLE_BITS >= 12 and ADC_SAMPLE_BITS <= 14,
+    "ADC_SAMPLE_BITS must be 12 to 14");
+
 namespace mobilinkd { namespace tnc { namespace audio {
 
 void init_log_volume();
+void set_input_gain(int level);
+
+/// The input gain last set with set_input_gain(), 0-4.
+int input_gain();
 void autoAudioInputLevel();
 void setAudioInputLevels();
 void setAudioOutputLevel();
 
 extern bool streamInputDCOffset;
-constexpr const uint16_t vref = 16383; // Must match ADC output (adjust when oversampling)
+constexpr const uint32_t ADC_BITS = ADC_SAMPLE_BITS;
+constexpr const uint16_t vref = (1 << ADC_BITS) - 1;    // Full scale ADC output.
 extern uint16_t virtual_ground;
 extern float i_vgnd;
 
@@ -0,0 +1,143 @@
+// Copyright 2019 Rob Riggs <rob@mobilinkd.com>
+// All rights reserved.
+
+#ifndef MOBILINKD__TNC__BIQUAD_FILTER_HPP_
+#define MOBILINKD__TNC__BIQUAD_FILTER_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace mobilinkd { namespace tnc {
+
+/**
+ * The coefficients of one second-order section, {b0, b1, b2, a1, a2}.
+ * a0 is 1.  These are the rows of scipy.signal's "sos" output with the
+ * a0 column removed.
+ */
+template <typename T>
+using BiquadSection = std::array<T, 5>;
+
+template <typename T, size_t N>
+using BiquadCoefficients = std::array<BiquadSection<T>, N>;
+
+/**
+ * A cascade of N second-order IIR sections in transposed direct form II.
+ * Each section keeps two state variables; nothing is shifted per sample.
+ *
+ * The block operator runs each section over the whole block before the
+ * next, which keeps the coefficients and state in registers.  It gives
+ * the same result as filtering one sample at a time.
+ */
+template <size_t N>
+struct BiquadFilter
+{
+    typedef BiquadCoefficients<float, N> coefficients_type;
+
+    const coefficients_type& sos_;
+    float state_[N][2];
+
+    BiquadFilter(const coefficients_type& sos)
+    : sos_(sos), state_()
+    {}
+
+    void reset()
+    {
+        for (auto& z : state_) z[0] = z[1] = 0.0f;
+    }
+
+    float operator()(float input)
+    {
+        float x = input;
+        for (size_t i = 0; i != N; i++) {
+            x = section(sos_[i], state_[i], x);
+        }
+        return x;
+    }
+
+    /// Filter len samples from input to output; they may be the same.
+    void operator()(const float* input, float* output, size_t len)
+    {
+        const float* in = input;
+        for (size_t i = 0; i != N; i++) {
+            const auto& c = sos_[i];
+            auto& z = state_[i];
+            for (size_t j = 0; j != len; j++) {
+                output[j] = section(c, z, in[j]);
+            }
+            in = output;
+        }
+    }
+
+private:
+
+    static float section(const BiquadSection<float>& c, float* z, float x)
+    {
+        float y = c[0] * x + z[0];
+        z[0] = c[1] * x - c[3] * y + z[1];
+        z[1] = c[2] * x - c[4] * y;
+        return y;
+    }
+};
+
+/**
+ * A fixed-point version of BiquadFilter.  The coefficients have
+ * FRACTION_BITS fractional bits, so Q29 allows coefficients up to +/-4,
+ * enough for any stable section.  The state is 64 bits wide.  The input
+ * and output can be in any fixed-point format that leaves room for the
+ * filter's gain.
+ */
+template <size_t N, int FRACTION_BITS = 29>
+struct FixedBiquadFilter
+{
+    typedef BiquadCoefficients<int32_t, N> coefficients_type;
+
+    const coefficients_type& sos_;
+    int64_t state_[N][2];
+
+    FixedBiquadFilter(const coefficients_type& sos)
+    : sos_(sos), state_()
+    {}
+
+    void reset()
+    {
+        for (auto& z : state_) z[0] = z[1] = 0;
+    }
+
+    int32_t operator()(int32_t input)
+    {
+        int32_t x = input;
+        for (size_t i = 0; i != N; i++) {
+            x = section(sos_[i], state_[i], x);
+        }
+        return x;
+    }
+
+    /// Filter len samples from input to output; they may be the same.
+    void operator()(const int32_t* input, int32_t* output, size_t len)
+    {
+        const int32_t* in = input;
+        for (size_t i = 0; i != N; i++) {
+            const auto& c = sos_[i];
+            auto& z = state_[i];
+            for (size_t j = 0; j != len; j++) {
+                output[j] = section(c, z, in[j]);
+            }
+            in = output;
+        }
+    }
+
+private:
+
+    static int32_t section(const BiquadSection<int32_t>& c, int64_t* z, int32_t x)
+    {
+        int64_t y = (int64_t(c[0]) * x + z[0]) >> FRACTION_BITS;
+        z[0] = int64_t(c[1]) * x - int64_t(c[3]) * y + z[1];
+        z[1] = int64_t(c[2]) * x - int64_t(c[4]) * y;
+        return y;
+    }
+};
+
+}} // mobilinkd::tnc
+
+#endif // MOBILINKD__TNC__BIQUAD_FILTER_HPP_
@@ -0,0 +1,48 @@
+// Copyright 2019 Rob Riggs <rob@mobilinkd.com>
+// All rights reserved.
+
+#include "CorrelatorDemodulator.hpp"
+
+namespace mobilinkd { namespace tnc {
+
+q15_t Nco::sin_table_[Nco::TABLE_LEN];
+
+void Nco::init_table()
+{
+    static bool initialized = false;
+    if (initialized) return;
+
+    for (size_t i = 0; i != TABLE_LEN; i++) {
+        sin_table_[i] = __SSAT(std::lround(
+            std::sin(2.0f * float(M_PI) * i / TABLE_LEN) * 32768.0f), 16);
+    }
+    initialized = true;
+}
+
+hdlc::IoFrame* CorrelatorBranch::operator()(const uint32_t* levels, size_t len)
+{
+    hdlc::IoFrame* result = 0;
+
+    for (size_t i = 0; i != len; i++) {
+        bool bit = (levels[i / 32] >> (i % 32)) & 1;
+        auto pll = pll_(bit);
+
+        if (pll.sample) {
+            locked_ = pll.locked;
+
+            if (not hdlc_bits_(nrzi_.decode(bit))) continue;
+
+            // We will only ever get one frame because there are
+            // not enough bits in a block for more than one.
+            if (result) {
+                auto tmp = hdlc_decoder_(hdlc_bits_.byte());
+                if (tmp) hdlc::release(tmp);
+            } else {
+                result = hdlc_decoder_(hdlc_bits_.byte());
+            }
+        }
+    }
+    return result;
+}
+
+}} // mobilinkd::tnc
@@ -0,0 +1,268 @@
+// Copyright 2019 Rob Riggs <rob@mobilinkd.com>
+// All rights reserved.
+
+#ifndef MOBILINKD__TNC__CORRELATOR_DEMODULATOR_HPP_
+#define MOBILINKD__TNC__CORRELATOR_DEMODULATOR_HPP_
+
+#include <arm_math.h>
+#include "AudioInput.hpp"
+#include "DigitalPLL.hpp"
+#include "HdlcDecoder.hpp"
+#include "NRZI.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+namespace mobilinkd { namespace tnc {
+
+/**
+ * A numerically controlled oscillator.  The phase is a 32-bit accumulator
+ * and the top TABLE_BITS of it index a shared sine table.  Each call
+ * returns cos (low half-word) and sin (high half-word) as Q15, packed for
+ * the halfword multiply instructions.
+ */
+struct Nco
+{
+    static constexpr size_t TABLE_BITS = 8;
+    static constexpr size_t TABLE_LEN = 1 << TABLE_BITS;
+    static constexpr uint32_t QUARTER = TABLE_LEN / 4;
+
+    static q15_t sin_table_[TABLE_LEN];
+
+    uint32_t phase_{0};
+    uint32_t step_;
+
+    Nco(uint32_t frequency, uint32_t sample_rate)
+    : step_((uint64_t(frequency) << 32) / sample_rate)
+    {
+        init_table();
+    }
+
+    uint32_t operator()()
+    {
+        const uint32_t index = phase_ >> (32 - TABLE_BITS);
+        phase_ += step_;
+        return uint16_t(sin_table_[(index + QUARTER) % TABLE_LEN])
+            | (uint32_t(uint16_t(sin_table_[index])) << 16);
+    }
+
+    void reset() { phase_ = 0; }
+
+    /// Fill sin_table_.  Only the first call does any work.
+    static void init_table();
+};
+
+/**
+ * The part of the correlator demodulator that follows the mark/space
+ * decision.  This is the clock recovery PLL, the NRZI decoder and the
+ * HDLC decoder.  Each twist branch has its own instance of this.
+ */
+struct CorrelatorBranch
+{
+    typedef FixedDigitalPLL DPLL;
+
+    DPLL pll_;
+    libafsk::NRZI nrzi_;
+    hdlc::BitPacker hdlc_bits_;
+    hdlc::NewDecoder hdlc_decoder_;
+    bool locked_;
+
+    CorrelatorBranch(uint32_t sample_rate, uint32_t symbol_rate)
+    : pll_(sample_rate, symbol_rate)
+    , nrzi_(), hdlc_decoder_(false), locked_(false)
+    {}
+
+    /**
+     * Decode a block of mark/space decisions.
+     *
+     * @param levels are the decisions, one bit per sample (1 for mark),
+     *  packed LSB-first.
+     * @param len is the number of samples.
+     * @return a decoded frame or nullptr.
+     */
+    hdlc::IoFrame* operator()(const uint32_t* levels, size_t len);
+
+    bool locked() const {return locked_;}
+};
+
+/**
+ * A non-coherent FSK demodulator.  The input is mixed with the mark and
+ * space tones and each I/Q product is summed over a sliding window of one
+ * symbol (a matched filter for a rectangular symbol).  The normalized
+ * difference of the mark and space energies is smoothed by a one-pole
+ * low-pass filter and its sign is the mark/space decision.  Without the
+ * normalization and smoothing this decodes about 30% fewer packets.
+ *
+ * The correlation is done once per sample; the branches only differ in the
+ * weight given to the space energy.  This compensates for twist in the
+ * same way the emphasis filters do for the discriminator, at the cost of
+ * a few float operations per branch instead of a filter.
+ *
+ * The tones and symbol rate are set at run time so that the same code can
+ * be used for other Bell 202-like modems.  WINDOW must be the number of
+ * samples per symbol.
+ */
+template <size_t BRANCHES, size_t WINDOW,
+    size_t BLOCK_SIZE = audio::ADC_BUFFER_SIZE>
+struct CorrelatorDemodulator
+{
+    typedef std::array<hdlc::IoFrame*, BRANCHES> result_type;
+
+    static constexpr size_t LEVEL_WORDS = (BLOCK_SIZE + 31) / 32;
+
+    // The smoothing filter coefficient; 0.18 at 1200 baud.
+    static constexpr float SMOOTHING = 4.0f / WINDOW;
+
+    enum {MARK_I, MARK_Q, SPACE_I, SPACE_Q, CORRELATORS};
+
+    Nco mark_;
+    Nco space_;
+    int16_t history_[WINDOW][CORRELATORS];
+    int32_t sums_[CORRELATORS];
+    size_t pos_;
+    float weight_[BRANCHES];                    // Space energy weight.
+    float metric_[BRANCHES];                    // Smoothed decision metric.
+    uint32_t levels_[BRANCHES][LEVEL_WORDS];
+    std::array<CorrelatorBranch, BRANCHES> branches_;
+
+    CorrelatorDemodulator(uint32_t sample_rate, uint32_t mark, uint32_t space,
+        uint32_t symbol_rate)
+    : mark_(mark, sample_rate), space_(space, sample_rate)
+    , history_(), sums_(), pos_(0), weight_(), metric_(), levels_()
+    , branches_(make_branches(sample_rate, symbol_rate,
+        std::make_index_sequence<BRANCHES>()))
+    {
+        std::fill(weight_, weight_ + BRANCHES, 1.0f);
+    }
+
+    /**
+     * Set the twist compensation for one branch and clear the correlator
+     * history.
+     *
+     * @param twist is the gain applied to the space tone, in dB.
+     */
+    void init(size_t branch, int twist)
+    {
+        this->twist(branch, twist);
+        metric_[branch] = 0.0f;
+        memset(history_, 0, sizeof(history_));
+        memset(sums_, 0, sizeof(sums_));
+        pos_ = 0;
+        mark_.reset();
+        space_.reset();
+    }
+
+    /**
+     * Set the twist compensation for one branch.  This can be used while
+     * the demodulator is running.
+     *
+     * @param twist is the gain applied to the space tone, in dB.
+     */
+    void twist(size_t branch, int twist)
+    {
+        weight_[branch] = std::pow(10.0f, twist / 10.0f);
+    }
+
+    static constexpr size_t size() { return BRANCHES; }
+
+    result_type operator()(const q15_t* samples, size_t len)
+    {
+        uint32_t budget = hdlc::FIX_BITS_TRIALS_PER_BLOCK;
+        return (*this)(samples, len, budget);
+    }
+
+    /**
+     * Demodulate a block of samples, sharing the fix bits budget with
+     * other demodulators running on the same block.
+     *
+     * @param budget is the number of fix bits trials left for this block.
+     *  It is reduced by the trials used.
+     */
+    result_type operator()(const q15_t* samples, size_t len, uint32_t& budget)
+    {
+        memset(levels_, 0, sizeof(levels_));
+
+        for (size_t i = 0; i != len; i++) {
+            // These compile to SMULBB/SMULBT.
+            const int32_t x = samples[i];
+            const uint32_t m = mark_();
+            const uint32_t s = space_();
+            const int16_t products[CORRELATORS] = {
+                int16_t((x * int16_t(m)) >> 15), int16_t((x * int16_t(m >> 16)) >> 15),
+                int16_t((x * int16_t(s)) >> 15), int16_t((x * int16_t(s >> 16)) >> 15)
+            };
+
+            int16_t* h = history_[pos_];
+            for (size_t j = 0; j != CORRELATORS; j++) {
+                sums_[j] += products[j] - h[j];
+                h[j] = products[j];
+            }
+            if (++pos_ == WINDOW) pos_ = 0;
+
+            const float mark_energy = energy(sums_[MARK_I], sums_[MARK_Q]);
+            const float space_energy = energy(sums_[SPACE_I], sums_[SPACE_Q]);
+
+            for (size_t k = 0; k != BRANCHES; k++) {
+                const float weighted_space = space_energy * weight_[k];
+                const float metric = (mark_energy - weighted_space)
+                    / (mark_energy + weighted_space + 1.0f);
+                metric_[k] += SMOOTHING * (metric - metric_[k]);
+                levels_[k][i / 32] |= uint32_t(metric_[k] >= 0.0f) << (i % 32);
+            }
+        }
+
+        result_type result;
+        for (size_t k = 0; k != BRANCHES; k++) {
+            auto& decoder = branches_[k].hdlc_decoder_;
+            decoder.fix_bits_budget = budget;
+            result[k] = branches_[k](levels_[k], len);
+            budget = decoder.fix_bits_budget;
+        }
+        return result;
+    }
+
+    /// Set the fix bits mode of all branches and reset their statistics.
+    void fix_bits(hdlc::FixBits mode)
+    {
+        for (auto& branch : branches_) {
+            branch.hdlc_decoder_.fix_bits_mode = mode;
+            branch.hdlc_decoder_.fix_bits_stats = hdlc::FixBitsStats();
+        }
+    }
+
+    hdlc::FixBitsStats fix_bits_stats() const
+    {
+        hdlc::FixBitsStats result;
+        for (const auto& branch : branches_) {
+            result += branch.hdlc_decoder_.fix_bits_stats;
+        }
+        return result;
+    }
+
+    bool locked() const
+    {
+        return std::any_of(branches_.begin(), branches_.end(),
+            [](const CorrelatorBranch& b) { return b.locked(); });
+    }
+
+private:
+
+    static float energy(int32_t i, int32_t q)
+    {
+        return float(i) * float(i) + float(q) * float(q);
+    }
+
+    template <size_t... I>
+    static std::array<CorrelatorBranch, BRANCHES> make_branches(
+        uint32_t sample_rate, uint32_t symbol_rate, std::index_sequence<I...>)
+    {
+        return {{(void(I), CorrelatorBranch(sample_rate, symbol_rate))...}};
+    }
+};
+
+}} // mobilinkd::tnc
+
+#endif // MOBILINKD__TNC__CORRELATOR_DEMODULATOR_HPP_
@@ -0,0 +1,69 @@
+// Copyright 2019 Rob Riggs <rob@mobilinkd.com>
+// All rights reserved.
+
+#ifndef MOBILINKD__TNC__CYCLE_COUNTER_HPP_
+#define MOBILINKD__TNC__CYCLE_COUNTER_HPP_
+
+#include "stm32l4xx_hal.h"
+
+#include <cstdint>
+#include <limits>
+
+namespace mobilinkd { namespace tnc {
+
+/**
+ * Measure the CPU cycles spent in a section of code using the DWT cycle
+ * counter.  This is used to measure the cost of each DSP block so that
+ * changes to the demodulator can be compared on the hardware.
+ *
+ * The DWT counter is free-running and wraps every ~89 seconds at 48MHz.
+ * Only sections shorter than that can be measured.
+ */
+struct CycleCounter
+{
+    uint32_t start_{0};
+    uint32_t count_{0};
+    uint32_t min_{std::numeric_limits<uint32_t>::max()};
+    uint32_t max_{0};
+    uint64_t total_{0};
+
+    /// Enable the trace unit and the DWT cycle counter.
+    static void enable()
+    {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CYCCNT = 0;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+
+    void start()
+    {
+        start_ = DWT->CYCCNT;
+    }
+
+    uint32_t stop()
+    {
+        uint32_t elapsed = DWT->CYCCNT - start_;
+        ++count_;
+        total_ += elapsed;
+        if (elapsed < min_) min_ = elapsed;
+        if (elapsed > max_) max_ = elapsed;
+        return elapsed;
+    }
+
+    void reset()
+    {
+        count_ = 0;
+        min_ = std::numeric_limits<uint32_t>::max();
+        max_ = 0;
+        total_ = 0;
+    }
+
+    uint32_t count() const { return count_; }
+    uint32_t min() const { return count_ ? min_ : 0; }
+    uint32_t max() const { return max_; }
+    uint32_t average() const { return count_ ? total_ / count_ : 0; }
+};
+
+}} // mobilinkd::tnc
+
+#endif // MOBILINKD__TNC__CYCLE_COUNTER_HPP_
@@ -50,29 +50,57 @@ struct FixedDelayLine {
 	}
 };
 
-#if 0
-template <size_t BLOCK_SIZE, size_t DELAY_BITS>
+/**
+ * A delay line for a block of bits, used for the XOR (delay and multiply)
+ * discriminator.  The input is the sign bits of a block of samples, packed
+ * LSB-first into 32-bit words.  The output is the input XOR the delayed
+ * input, in the same format, computed 32 samples at a time.
+ *
+ * The delay must be between 1 and 31 samples.
+ */
+template <size_t BLOCK_SIZE>
 struct BlockDelayLine {
 
-    uint8_t buffer_[(BLOCK_SIZE + DELAY_BITS + 7) / 8];
-    size_t pos_;
+    static constexpr size_t WORDS = (BLOCK_SIZE + 31) / 32;
+
+    size_t length_;
+    uint32_t buffer_[WORDS + 1];    ///< Last 32 bits of the previous block, then this one.
+    uint32_t output_[WORDS];
 
     BlockDelayLine(double sample_rate, double delay)
-    : length_((delay / (1.0 / sample_rate)) + .5), buffer_(), pos_(0)
+    : length_((delay / (1.0 / sample_rate)) + .5), buffer_(), output_()
     {
-        assert(length_ <= N);
-        memset(buffer_, 0, N);
+        assert(length_ > 0 and length_ < 32);
     }
 
-    bool operator()(bool value) {
-        bool r = buffer_[pos_];
-        buffer_[pos_++] = value;
-        if (pos_ == length_) pos_ = 0;
-        return r;
+    /**
+     * XOR each bit with the bit length_ samples earlier.
+     *
+     * @param levels are the packed input bits, (len + 31) / 32 words.
+     * @param len is the number of bits, at most BLOCK_SIZE.
+     * @return the packed discriminator output.
+     */
+    const uint32_t* operator()(const uint32_t* levels, size_t len)
+    {
+        const size_t words = (len + 31) / 32;
+        memcpy(buffer_ + 1, levels, words * sizeof(uint32_t));
+
+        for (size_t i = 0; i != words; i++) {
+            uint32_t delayed = (buffer_[i + 1] << length_)
+                | (buffer_[i] >> (32 - length_));
+            output_[i] = buffer_[i + 1] ^ delayed;
+        }
+
+        // Keep the last 32 bits.  Bit n of the block is bit n + 32 here.
+        const size_t word = len / 32;
+        const size_t shift = len % 32;
+        buffer_[0] = shift == 0 ? buffer_[word] :
+            (buffer_[word] >> shift) | (buffer_[word + 1] << (32 - shift));
+
+        return output_;
     }
 };
 
-#endif
 }} // mobilinkd::libafsk
 
 #endif // MOBILINKD_DELAY_LINE_H_
@@ -2,7 +2,8 @@
 #define MOBILINKD__DIGITAL_PLL_H_
 
 #include "Hysteresis.hpp"
-#include "IirFilter.hpp"
+#include "BiquadFilter.hpp"
+#include "FilterDesign.hpp"
 #include "FirFilter.hpp"
 
 #include "arm_math.h"
@@ -11,6 +12,8 @@
 #include <numeric>
 #include <array>
 #include <cmath>
+#include <cstdint>
+#include <cstdlib>
 #include <cstring>
 
 namespace mobilinkd { namespace tnc {
@@ -25,26 +28,51 @@ struct PLLResult {
     bool locked;
 };
 
-// Lock low-pass filter taps (80Hz Bessel)
-// scipy.signal:
-//      b, a = bessel(4, [80.0/(1200/2)], 'lowpass')
-//
-const std::array<float, 5> lock_b = {
-    1.077063e-03,4.308253e-03,6.462379e-03,4.308253e-03,1.077063e-03,
-};
-const std::array<float, 5> lock_a = {
-    1.000000e+00,-2.774567e+00,2.962960e+00,-1.437990e+00,2.668296e-01,
-};
+/*
+ * The PLL filters run once per symbol, so they are designed for a sample
+ * rate of 1200 and apply to any symbol rate.
+ */
+constexpr double FILTER_RATE = 1200.0;
 
-// 64 Hz loop filter.
+// 64 Hz loop filter.  The end taps, which are 0, are removed.
 // scipy.signal:
 //      loop_coeffs = firwin(9, [64.0/(1200/2)], width = None,
 //          pass_zero = True, scale = True, window='hann')
 //
-const std::array<float, 7> loop_coeffs = {
-//     0.08160962754214955, 0.25029850550446403, 0.3361837339067726, 0.2502985055044641, 0.08160962754214969
-    3.196252e-02,1.204223e-01,2.176819e-01,2.598666e-01,2.176819e-01,1.204223e-01,3.196252e-02
-};
+constexpr auto loop_design = filter::design::trim<1>(
+    filter::design::firwin<9>(64.0, FILTER_RATE, filter::design::Window::HANN));
+
+constexpr auto loop_coeffs = filter::design::convert<float>(loop_design);
+
+// loop_coeffs in Q15.
+constexpr auto loop_coeffs_q15 =
+    filter::design::quantize<int16_t, 15>(loop_design);
+
+static_assert(filter::design::fingerprint(loop_coeffs_q15) == 0x0e209fa8,
+    "loop_coeffs does not match the scipy design");
+
+// Lock low-pass filter (80Hz Bessel) as two second-order sections
+// {b0, b1, b2, a1, a2}.
+// scipy.signal:
+//      sos = bessel(4, [80.0/(1200/2)], 'lowpass', output='sos')
+//
+constexpr auto lock_design = filter::design::bessel<4>(80.0, FILTER_RATE);
+
+constexpr auto lock_sos = filter::design::convert<float>(lock_design);
+
+// lock_sos in Q29.
+//      np.round(sos * 2**29)
+//
+constexpr auto lock_sos_q29 =
+    filter::design::quantize<int32_t, 29>(lock_design);
+
+// The tables this replaced were computed from the transfer function
+// rounded to 7 digits, so they differ from the design by about 1e-5.
+static_assert(filter::design::near(lock_design[0][3], -1.347027780, 1e-4)
+    and filter::design::near(lock_design[0][4], 4.601509395e-01, 1e-4)
+    and filter::design::near(lock_design[1][3], -1.427539220, 1e-4)
+    and filter::design::near(lock_design[1][4], 5.798740741e-01, 1e-4),
+    "lock_sos does not match the scipy design");
 
 } // pll
 
@@ -60,7 +88,7 @@ struct BaseDigitalPLL
 	float_type limit_;			///< Samples per symbol / 2
 	libafsk::BaseHysteresis<float_type> lock_;
     FirFilter<1, 7> loop_filter_{pll::loop_coeffs.begin()};
-    IirFilter<5> lock_filter_{pll::lock_b, pll::lock_a};
+    BiquadFilter<2> lock_filter_{pll::lock_sos};
 
 	bool last_;
 	float_type count_;
@@ -126,6 +154,106 @@ struct BaseDigitalPLL
 typedef BaseDigitalPLL<double> DigitalPLL;
 typedef BaseDigitalPLL<float> FastDigitalPLL;
 
+/**
+ * A fixed-point version of BaseDigitalPLL that uses no floating point and
+ * no library calls.  Sample counts are Q16.  The loop filter is a 7-tap
+ * symmetric FIR, unrolled; the lock filter is a FixedBiquadFilter with
+ * Q29 coefficients.
+ */
+struct FixedDigitalPLL
+{
+    typedef int32_t fixed_type;     ///< Q16
+    typedef pll::PLLResult<fixed_type> result_type;
+
+    static constexpr int FRACTION_BITS = 16;
+    static constexpr int LOOP_BITS = 15;
+
+    fixed_type sps_;                ///< Samples per symbol
+    fixed_type limit_;              ///< Samples per symbol / 2
+    libafsk::BaseHysteresis<fixed_type> lock_;
+    std::array<fixed_type, 7> loop_history_;
+    FixedBiquadFilter<2, 29> lock_filter_{pll::lock_sos_q29};
+
+    bool last_;
+    fixed_type count_;
+
+    bool sample_;
+    fixed_type jitter_;
+    uint8_t bits_;
+
+    FixedDigitalPLL(uint32_t sample_rate, uint32_t symbol_rate)
+    : sps_((int64_t(sample_rate) << FRACTION_BITS) / symbol_rate)
+    , limit_(sps_ / 2)
+    , lock_(sps_ * 3 / 100, sps_ * 15 / 100, 1, 0)
+    , loop_history_()
+    , last_(false), count_(0), sample_(false)
+    , jitter_(0), bits_(1)
+    {}
+
+    result_type operator()(bool input)
+    {
+        sample_ = false;
+
+        if (input != last_ or bits_ > 16) {
+            // Record transition.
+            last_ = input;
+
+            if (count_ > limit_) {
+                count_ -= sps_;
+            }
+
+            // Force lock off when no stimulus is present (squelch closed).
+            const fixed_type adjust = bits_ > 16 ? (5 << FRACTION_BITS) : 0;
+
+            const fixed_type offset = count_ / bits_;
+            const fixed_type jitter = loop_filter(offset);
+            const fixed_type abs_offset = std::abs(offset) + adjust;
+            jitter_ = lock_filter_(abs_offset);
+
+            count_ -= jitter / 2;
+
+            bits_ = 1;
+        } else {
+            if (count_ > limit_) {
+                sample_ = true;
+                count_ -= sps_;
+                ++bits_;
+            }
+        }
+
+        count_ += (1 << FRACTION_BITS);
+        result_type result = {jitter_, sample_, locked()};
+        return result;
+    }
+
+    bool locked() {
+        return lock_(jitter_);
+    }
+
+    bool sample() const {
+        return sample_;
+    }
+
+private:
+
+    fixed_type loop_filter(fixed_type input)
+    {
+        auto& h = loop_history_;
+        const auto& c = pll::loop_coeffs_q15;
+
+        h[0] = h[1]; h[1] = h[2]; h[2] = h[3];
+        h[3] = h[4]; h[4] = h[5]; h[5] = h[6];
+        h[6] = input;
+
+        int64_t accum = int64_t(c[0]) * (h[0] + h[6])
+            + int64_t(c[1]) * (h[1] + h[5])
+            + int64_t(c[2]) * (h[2] + h[4])
+            + int64_t(c[3]) * h[3];
+
+        return accum >> LOOP_BITS;
+    }
+};
+
 }} // mobilinkd::tnc
 
 #endif // MOBILINKD__DIGITAL_PLL_H_
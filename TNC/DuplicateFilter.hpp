@@ -0,0 +1,96 @@
+// Copyright 2019 Rob Riggs <rob@mobilinkd.com>
+// All rights reserved.
+
+#ifndef MOBILINKD__TNC__DUPLICATE_FILTER_HPP_
+#define MOBILINKD__TNC__DUPLICATE_FILTER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace mobilinkd { namespace tnc {
+
+/**
+ * Suppress the copies of a frame decoded by more than one demodulator
+ * branch.  The FCS and length of each forwarded frame are kept in a small
+ * ring along with the time it was seen.  A frame is a duplicate if the
+ * same key was seen less than window_ ticks ago.
+ *
+ * The ring is searched linearly; with so few entries that is cheaper
+ * than hashing.  The oldest entry is replaced when the ring is full.
+ *
+ * A packet cannot be sent twice in less than its own air time, so the
+ * window only has to cover the skew between branches.  It must be well
+ * under the air time of the shortest frame to let real retransmissions
+ * through.
+ *
+ * @tparam N is the number of entries in the ring.
+ */
+template <size_t N>
+struct DuplicateFilter
+{
+    struct Entry
+    {
+        uint32_t key;
+        uint32_t time;
+        bool valid;
+    };
+
+    Entry entries_[N];
+    size_t next_;
+    uint32_t window_;       ///< In ticks (ms).
+    uint32_t hits_;         ///< Duplicates suppressed.
+    uint32_t misses_;       ///< Frames not seen before.
+
+    DuplicateFilter(uint32_t window)
+    : entries_(), next_(0), window_(window), hits_(0), misses_(0)
+    {}
+
+    static uint32_t key(uint16_t fcs, uint16_t size)
+    {
+        return (uint32_t(size) << 16) | fcs;
+    }
+
+    /**
+     * Check for a duplicate.  This updates the hit/miss counters but does
+     * not add the frame; call add() once the frame has been forwarded.
+     *
+     * @param key is from key().
+     * @param now is the current tick count.
+     * @return true if the frame is a duplicate.
+     */
+    bool operator()(uint32_t key, uint32_t now)
+    {
+        for (const auto& entry : entries_) {
+            if (entry.valid and entry.key == key and now - entry.time < window_) {
+                ++hits_;
+                return true;
+            }
+        }
+        ++misses_;
+        return false;
+    }
+
+    void add(uint32_t key, uint32_t now)
+    {
+        entries_[next_] = {key, now, true};
+        if (++next_ == N) next_ = 0;
+    }
+
+    /// Forget all frames and reset the counters.
+    void reset()
+    {
+        for (auto& entry : entries_) entry.valid = false;
+        next_ = 0;
+        hits_ = 0;
+        misses_ = 0;
+    }
+
+    void window(uint32_t ticks) { window_ = ticks; }
+    uint32_t window() const { return window_; }
+    uint32_t hits() const { return hits_; }
+    uint32_t misses() const { return misses_; }
+};
+
+}} // mobilinkd::tnc
+
+#endif // MOBILINKD__TNC__DUPLICATE_FILTER_HPP_
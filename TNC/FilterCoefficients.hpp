@@ -4,196 +4,80 @@
 #ifndef MOBILINKD__TNC__FILTER_COEFFICIENTS_HPP_
 #define MOBILINKD__TNC__FILTER_COEFFICIENTS_HPP_
 
-#include "IirFilter.hpp"
+#include "AudioInput.hpp"
+#include "FilterDesign.hpp"
 #include "FirFilter.hpp"
 
 namespace mobilinkd { namespace tnc { namespace filter {
 
 namespace fir {
 
+/**
+ * The AFSK emphasis filters.  These are 9-tap windowed-sinc filters
+ * scaled by a gain.  A high-pass filter cuts 1200Hz relative to 2200Hz;
+ * a low-pass filter cuts 2200Hz.  The cutoff and gain of each were chosen
+ * for its levels at 26400Hz.
+ *
+ * gain * firwin(9, cutoff, fs=sample_rate, window=w, pass_zero=not highpass)
+ */
+constexpr TFirCoefficients<9> emphasis(double cutoff, double gain,
+    design::Window w, bool highpass)
+{
+    const auto h = design::firwin<9>(cutoff, audio::SAMPLE_RATE, w, highpass);
+    TFirCoefficients<9> result{};
+    for (size_t i = 0; i != 9; ++i) result.taps[i] = float(gain * h[i]);
+    return result;
+}
+
 // 1200Hz = -12dB, 2200Hz = 0dB; 3653Hz cutoff, 4.93 gain; cosine.
-const TFirCoefficients<9> dB12 = {
-    {
-        0.0223997567081,
-        -0.132588208904,
-        -0.590869965255,
-        -1.12325491747,
-        3.55525416434,
-        -1.12325491747,
-        -0.590869965255,
-        -0.132588208904,
-        0.0223997567081,
-    }
-};
+constexpr TFirCoefficients<9> dB12 =
+    emphasis(3653.0, 4.93, design::Window::COSINE, true);
 
 // 1200Hz = -11dB, 2200Hz = 0dB; 3537Hz cutoff, 4.51 gain; cosine.
-const TFirCoefficients<9> dB11 = {
-    {
-        0.0138943225784,
-        -0.137800909104,
-        -0.544488104185,
-        -1.00269495093,
-        3.29019584315,
-        -1.00269495093,
-        -0.544488104185,
-        -0.137800909104,
-        0.0138943225784,
-    }
-};
+constexpr TFirCoefficients<9> dB11 =
+    emphasis(3537.0, 4.51, design::Window::COSINE, true);
 
 // 1200Hz = -10dB, 2200Hz = 0dB; 3405Hz cutoff, 4.11 gain; cosine.
-const TFirCoefficients<9> dB10 = {
-    {
-        0.00564557245371,
-        -0.141643920093,
-        -0.498513944796,
-        -0.887264289827,
-        3.03792032485,
-        -0.887264289827,
-        -0.498513944796,
-        -0.141643920093,
-        0.00564557245371,
-    }
-};
+constexpr TFirCoefficients<9> dB10 =
+    emphasis(3405.0, 4.11, design::Window::COSINE, true);
 
 // 1200Hz = -9dB, 2200Hz = 0dB; 3252Hz cutoff, 3.7 gain; cosine.
-const TFirCoefficients<9> dB9 = {
-    {
-        -0.00232554104135,
-        -0.142858725752,
-        -0.449053780255,
-        -0.770264863826,
-        2.77651146344,
-        -0.770264863826,
-        -0.449053780255,
-        -0.142858725752,
-        -0.00232554104135,
-    }
-};
+constexpr TFirCoefficients<9> dB9 =
+    emphasis(3252.0, 3.7, design::Window::COSINE, true);
 
 // 1200Hz = -8dB, 2200Hz = 0dB; 3075Hz cutoff, 3.31 gain; cosine.
-const TFirCoefficients<9> dB8 = {
-    {
-        -0.0096785005294,
-        -0.141786249744,
-        -0.399423790874,
-        -0.658608816643,
-        2.52741445003,
-        -0.658608816643,
-        -0.399423790874,
-        -0.141786249744,
-        -0.0096785005294,
-    }
-};
+constexpr TFirCoefficients<9> dB8 =
+    emphasis(3075.0, 3.31, design::Window::COSINE, true);
 
-// 1200Hz = -7dB, 2200Hz = 0dB; 2874Hz cutoff, 2.949 gain; cosine.
-const TFirCoefficients<9> dB7 = {
-    {
-        -0.0159546975608,
-        -0.137623905223,
-        -0.349491872081,
-        -0.553149017309,
-        2.28934729422,
-        -0.553149017309,
-        -0.349491872081,
-        -0.137623905223,
-        -0.0159546975608,
-    }
-};
+// 1200Hz = -7dB, 2200Hz = 0dB; 2874Hz cutoff, 2.94 gain; cosine.
+constexpr TFirCoefficients<9> dB7 =
+    emphasis(2874.0, 2.94, design::Window::COSINE, true);
 
 // 1200Hz = -6dB, 2200Hz = 0dB; 2640Hz cutoff, 2.59 gain; cosine.
-const TFirCoefficients<9> dB6 = {
-    {
-        -0.0209448226653,
-        -0.130107651829,
-        -0.299004731072,
-        -0.45336946386,
-        2.0629448761,
-        -0.45336946386,
-        -0.299004731072,
-        -0.130107651829,
-        -0.0209448226653,
-    }
-};
+constexpr TFirCoefficients<9> dB6 =
+    emphasis(2640.0, 2.59, design::Window::COSINE, true);
 
-// 1200Hz = -5dB, 2200Hz = 0dB; 2372Hz cutoff, 2.26 gain; cosine.
-const TFirCoefficients<9> dB5 = {
-    {
-        -0.0209448226653,
-        -0.130107651829,
-        -0.299004731072,
-        -0.45336946386,
-        2.0629448761,
-        -0.45336946386,
-        -0.299004731072,
-        -0.130107651829,
-        -0.0209448226653,
-    }
-};
+// 1200Hz = -5dB, 2200Hz = 0dB; the same taps as dB6.
+constexpr TFirCoefficients<9> dB5 = dB6;
 
 
-// 1200Hz = -4dB, 2200Hz = 0dB; 2064Hz cutoff, 1.96 gain; cosine.
-const TFirCoefficients<9> dB4 = {
-    {
-        -0.0209448226653,
-        -0.130107651829,
-        -0.299004731072,
-        -0.45336946386,
-        2.0629448761,
-        -0.45336946386,
-        -0.299004731072,
-        -0.130107651829,
-        -0.0209448226653,
-    }
-};
+// 1200Hz = -4dB, 2200Hz = 0dB; the same taps as dB6.
+constexpr TFirCoefficients<9> dB4 = dB6;
 
 // 1200Hz = -3dB, 2200Hz = 0dB; 1700Hz cutoff, 1.68 gain; cosine.
-const TFirCoefficients<9> dB3 = {
-    {
-        -0.0231416146776,
-        -0.0833375337803,
-        -0.147937602401,
-        -0.197411259519,
-        1.46066084756,
-        -0.197411259519,
-        -0.147937602401,
-        -0.0833375337803,
-        -0.0231416146776,
-    }
-};
+constexpr TFirCoefficients<9> dB3 =
+    emphasis(1700.0, 1.68, design::Window::COSINE, true);
 
 
 // 1200Hz = -2dB, 2200Hz = 0dB; 1270Hz cutoff, 1.44 gain; cosine.
-const TFirCoefficients<9> dB2 = {
-    {
-        -0.0185923370593,
-        -0.0601029235689,
-        -0.0996864670836,
-        -0.128090353439,
-        1.30017105427,
-        -0.128090353439,
-        -0.0996864670836,
-        -0.0601029235689,
-        -0.0185923370593,
-    }
-};
+constexpr TFirCoefficients<9> dB2 =
+    emphasis(1270.0, 1.44, design::Window::COSINE, true);
 
 // 1200Hz = -1dB, 2200Hz = 0dB; 730Hz cutoff, 1.22 gain; cosine.
-const TFirCoefficients<9> dB1 = {
-    {
-        -0.0107931468169,
-        -0.0322211933056,
-        -0.0506402474814,
-        -0.0630689498437,
-        1.1522865023,
-        -0.0630689498437,
-        -0.0506402474814,
-        -0.0322211933056,
-        -0.0107931468169,
-    }
-};
+constexpr TFirCoefficients<9> dB1 =
+    emphasis(730.0, 1.22, design::Window::COSINE, true);
 
-const TFirCoefficients<9> dB0 = {
+constexpr TFirCoefficients<9> dB0 = {
     {
         1.0,
         1.0,
@@ -207,95 +91,28 @@ const TFirCoefficients<9> dB0 = {
     }
 };
 
-// 1200Hz = 0dB, 2200Hz = -1dB; 4280Hz cutoff, 1.045 gain; cosine.
-const TFirCoefficients<9> dB_1 = {
-    {
-        -0.0107931468169,
-        -0.0322211933056,
-        -0.0506402474814,
-        -0.0630689498437,
-        1.1522865023,
-        -0.0630689498437,
-        -0.0506402474814,
-        -0.0322211933056,
-        -0.0107931468169,
-    }
-};
+// 1200Hz = 0dB, 2200Hz = -1dB; the same taps as dB1.
+constexpr TFirCoefficients<9> dB_1 = dB1;
 
 // 1200Hz = 0dB, 2200Hz = -2dB; 3098Hz cutoff, 1.1 gain; cosine.
-const TFirCoefficients<9> dB_2 = {
-    {
-        0.00299520319909,
-        0.0482175156295,
-        0.137632853632,
-        0.228067265055,
-        0.266174324969,
-        0.228067265055,
-        0.137632853632,
-        0.0482175156295,
-        0.00299520319909,
-    }
-};
+constexpr TFirCoefficients<9> dB_2 =
+    emphasis(3098.0, 1.1, design::Window::COSINE, false);
 
 // 1200Hz = 0dB, 2200Hz = -3dB; 1830Hz cutoff, 1.149 gain; cosine.
-const TFirCoefficients<9> dB_3 = {
-    {
-        0.0221215152936,
-        0.0832006412609,
-        0.151534395598,
-        0.205025020719,
-        0.225236854257,
-        0.205025020719,
-        0.151534395598,
-        0.0832006412609,
-        0.0221215152936,
-    }
-};
+constexpr TFirCoefficients<9> dB_3 =
+    emphasis(1830.0, 1.149, design::Window::COSINE, false);
 
 // 1200Hz = 0dB, 2200Hz = -4dB; 2606Hz cutoff, 1.194 gain; boxcar.
-const TFirCoefficients<9> dB_4 = {
-    {
-        0.0498539382844,
-        0.103801174967,
-        0.153695746099,
-        0.188874162863,
-        0.201549955573,
-        0.188874162863,
-        0.153695746099,
-        0.103801174967,
-        0.0498539382844,
-    }
-};
+constexpr TFirCoefficients<9> dB_4 =
+    emphasis(2606.0, 1.194, design::Window::BOXCAR, false);
 
 // 1200Hz = 0dB, 2200Hz = -5dB; 2174Hz cutoff, 1.237 gain; boxcar.
-const TFirCoefficients<9> dB_5 = {
-    {
-        0.0782137588209,
-        0.118736939542,
-        0.153156300897,
-        0.176223458893,
-        0.184339083696,
-        0.176223458893,
-        0.153156300897,
-        0.118736939542,
-        0.0782137588209,
-    }
-};
+constexpr TFirCoefficients<9> dB_5 =
+    emphasis(2174.0, 1.237, design::Window::BOXCAR, false);
 
 // 1200Hz = 0dB, 2200Hz = -6dB; 1706Hz cutoff, 1.275 gain; boxcar.
-const TFirCoefficients<9> dB_6 = {
-    {
-        0.104477241089,
-        0.130913242609,
-        0.151854419973,
-        0.165293215366,
-        0.169923761926,
-        0.165293215366,
-        0.151854419973,
-        0.130913242609,
-        0.104477241089,
-    }
-};
+constexpr TFirCoefficients<9> dB_6 =
+    emphasis(1706.0, 1.275, design::Window::BOXCAR, false);
 
 const TFirCoefficients<9>* AfskFilters[] = {
   &dB_6,
@@ -319,6 +136,121 @@ const TFirCoefficients<9>* AfskFilters[] = {
   &dB12
 };
 
+/*
+ * The emphasis filters quantized for the fixed-point demodulator.  The
+ * largest tap is 3.56 so Q12 is used; the sum of the absolute values of
+ * the taps is at most 9, so a full-scale Q15 input cannot overflow a
+ * 32-bit accumulator.
+ */
+constexpr int AFSK_FILTER_FRACTION_BITS = 12;
+
+typedef TFixedFirCoefficients<9, AFSK_FILTER_FRACTION_BITS> afsk_fixed_filter_type;
+
+constexpr afsk_fixed_filter_type dB_6_q = quantize<AFSK_FILTER_FRACTION_BITS>(dB_6);
+constexpr afsk_fixed_filter_type dB_5_q = quantize<AFSK_FILTER_FRACTION_BITS>(dB_5);
+constexpr afsk_fixed_filter_type dB_4_q = quantize<AFSK_FILTER_FRACTION_BITS>(dB_4);
+constexpr afsk_fixed_filter_type dB_3_q = quantize<AFSK_FILTER_FRACTION_BITS>(dB_3);
+constexpr afsk_fixed_filter_type dB_2_q = quantize<AFSK_FILTER_FRACTION_BITS>(dB_2);
+constexpr afsk_fixed_filter_type dB_1_q = quantize<AFSK_FILTER_FRACTION_BITS>(dB_1);
+constexpr afsk_fixed_filter_type dB0_q = quantize<AFSK_FILTER_FRACTION_BITS>(dB0);
+constexpr afsk_fixed_filter_type dB1_q = quantize<AFSK_FILTER_FRACTION_BITS>(dB1);
+constexpr afsk_fixed_filter_type dB2_q = quantize<AFSK_FILTER_FRACTION_BITS>(dB2);
+constexpr afsk_fixed_filter_type dB3_q = quantize<AFSK_FILTER_FRACTION_BITS>(dB3);
+constexpr afsk_fixed_filter_type dB4_q = quantize<AFSK_FILTER_FRACTION_BITS>(dB4);
+constexpr afsk_fixed_filter_type dB5_q = quantize<AFSK_FILTER_FRACTION_BITS>(dB5);
+constexpr afsk_fixed_filter_type dB6_q = quantize<AFSK_FILTER_FRACTION_BITS>(dB6);
+constexpr afsk_fixed_filter_type dB7_q = quantize<AFSK_FILTER_FRACTION_BITS>(dB7);
+constexpr afsk_fixed_filter_type dB8_q = quantize<AFSK_FILTER_FRACTION_BITS>(dB8);
+constexpr afsk_fixed_filter_type dB9_q = quantize<AFSK_FILTER_FRACTION_BITS>(dB9);
+constexpr afsk_fixed_filter_type dB10_q = quantize<AFSK_FILTER_FRACTION_BITS>(dB10);
+constexpr afsk_fixed_filter_type dB11_q = quantize<AFSK_FILTER_FRACTION_BITS>(dB11);
+constexpr afsk_fixed_filter_type dB12_q = quantize<AFSK_FILTER_FRACTION_BITS>(dB12);
+
+/*
+ * The quantized taps of each emphasis filter hash to the same value as the
+ * table it replaced, which scipy made at 26400Hz.  test/filter_design
+ * compares the float taps.
+ */
+static_assert(audio::SAMPLE_RATE != 26400
+    or design::fingerprint(dB_6_q.taps) == 0x16d5a2af,
+    "dB_6 does not match the scipy design");
+static_assert(audio::SAMPLE_RATE != 26400
+    or design::fingerprint(dB_5_q.taps) == 0x09230b12,
+    "dB_5 does not match the scipy design");
+static_assert(audio::SAMPLE_RATE != 26400
+    or design::fingerprint(dB_4_q.taps) == 0x4b3a8851,
+    "dB_4 does not match the scipy design");
+static_assert(audio::SAMPLE_RATE != 26400
+    or design::fingerprint(dB_3_q.taps) == 0x3e320f32,
+    "dB_3 does not match the scipy design");
+static_assert(audio::SAMPLE_RATE != 26400
+    or design::fingerprint(dB_2_q.taps) == 0x0ab897c1,
+    "dB_2 does not match the scipy design");
+static_assert(audio::SAMPLE_RATE != 26400
+    or design::fingerprint(dB_1_q.taps) == 0x7329471f,
+    "dB_1 does not match the scipy design");
+static_assert(audio::SAMPLE_RATE != 26400
+    or design::fingerprint(dB0_q.taps) == 0x3eaf31ff,
+    "dB0 does not match the scipy design");
+static_assert(audio::SAMPLE_RATE != 26400
+    or design::fingerprint(dB1_q.taps) == 0x7329471f,
+    "dB1 does not match the scipy design");
+static_assert(audio::SAMPLE_RATE != 26400
+    or design::fingerprint(dB2_q.taps) == 0x1f9bd28d,
+    "dB2 does not match the scipy design");
+static_assert(audio::SAMPLE_RATE != 26400
+    or design::fingerprint(dB3_q.taps) == 0xec588a5e,
+    "dB3 does not match the scipy design");
+static_assert(audio::SAMPLE_RATE != 26400
+    or design::fingerprint(dB4_q.taps) == 0x0c2d12a5,
+    "dB4 does not match the scipy design");
+static_assert(audio::SAMPLE_RATE != 26400
+    or design::fingerprint(dB5_q.taps) == 0x0c2d12a5,
+    "dB5 does not match the scipy design");
+static_assert(audio::SAMPLE_RATE != 26400
+    or design::fingerprint(dB6_q.taps) == 0x0c2d12a5,
+    "dB6 does not match the scipy design");
+static_assert(audio::SAMPLE_RATE != 26400
+    or design::fingerprint(dB7_q.taps) == 0x395d8fe0,
+    "dB7 does not match the scipy design");
+static_assert(audio::SAMPLE_RATE != 26400
+    or design::fingerprint(dB8_q.taps) == 0x58bf10a7,
+    "dB8 does not match the scipy design");
+static_assert(audio::SAMPLE_RATE != 26400
+    or design::fingerprint(dB9_q.taps) == 0xe4acc2a4,
+    "dB9 does not match the scipy design");
+static_assert(audio::SAMPLE_RATE != 26400
+    or design::fingerprint(dB10_q.taps) == 0xcd672776,
+    "dB10 does not match the scipy design");
+static_assert(audio::SAMPLE_RATE != 26400
+    or design::fingerprint(dB11_q.taps) == 0xb423c674,
+    "dB11 does not match the scipy design");
+static_assert(audio::SAMPLE_RATE != 26400
+    or design::fingerprint(dB12_q.taps) == 0xda3cd17d,
+    "dB12 does not match the scipy design");
+
+const afsk_fixed_filter_type* AfskFixedFilters[] = {
+  &dB_6_q,
+  &dB_5_q,
+  &dB_4_q,
+  &dB_3_q,
+  &dB_2_q,
+  &dB_1_q,
+  &dB0_q,
+  &dB1_q,
+  &dB2_q,
+  &dB3_q,
+  &dB4_q,
+  &dB5_q,
+  &dB6_q,
+  &dB7_q,
+  &dB8_q,
+  &dB9_q,
+  &dB10_q,
+  &dB11_q,
+  &dB12_q
+};
+
 } // fir
 
 
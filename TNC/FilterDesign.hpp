@@ -0,0 +1,352 @@
+// Copyright 2019 Rob Riggs <rob@mobilinkd.com>
+// All rights reserved.
+
+#ifndef MOBILINKD__TNC__FILTER_DESIGN_HPP_
+#define MOBILINKD__TNC__FILTER_DESIGN_HPP_
+
+#include "BiquadFilter.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace mobilinkd { namespace tnc { namespace filter { namespace design {
+
+/*
+ * Compile-time filter design.  These are the scipy.signal designs that the
+ * coefficient tables were generated with, done by the compiler so that the
+ * tables follow the sample rate and band edges instead of being pasted in
+ * for one sample rate.  Everything here is constexpr; use the results to
+ * initialize constexpr tables so that nothing is computed at run time.
+ *
+ * The arithmetic follows scipy closely enough to give the same quantized
+ * taps.  fingerprint() is used next to each table to check that it still
+ * matches the table it replaced at the original sample rate.
+ */
+
+enum class Window { BOXCAR, COSINE, HANN, HAMMING };
+
+namespace detail {
+
+constexpr double pi = 3.14159265358979323846;
+
+// Taylor series for |x| <= pi/4.
+constexpr double sin_series(double x)
+{
+    const double x2 = x * x;
+    double term = x;
+    double result = x;
+    for (int i = 1; i != 12; ++i) {
+        term *= -x2 / ((2 * i) * (2 * i + 1));
+        result += term;
+    }
+    return result;
+}
+
+constexpr double cos_series(double x)
+{
+    const double x2 = x * x;
+    double term = 1.0;
+    double result = 1.0;
+    for (int i = 1; i != 12; ++i) {
+        term *= -x2 / ((2 * i - 1) * (2 * i));
+        result += term;
+    }
+    return result;
+}
+
+constexpr double cosine(double x)
+{
+    // Reduce to [0, pi], then to [0, pi/2], then to the series range.
+    const double turns = x / (2.0 * pi);
+    const long long k = static_cast<long long>(turns < 0 ? turns - 0.5 : turns + 0.5);
+    x -= k * (2.0 * pi);
+    if (x < 0) x = -x;
+
+    double sign = 1.0;
+    if (x > pi / 2) {
+        x = pi - x;
+        sign = -1.0;
+    }
+    return sign * (x > pi / 4 ? sin_series(pi / 2 - x) : cos_series(x));
+}
+
+constexpr double sine(double x)
+{
+    return cosine(pi / 2 - x);
+}
+
+constexpr double tangent(double x)
+{
+    return sine(x) / cosine(x);
+}
+
+/// np.sinc()
+constexpr double sinc(double x)
+{
+    return x == 0.0 ? 1.0 : sine(pi * x) / (pi * x);
+}
+
+/// scipy.signal.get_window(w, N, fftbins=False)
+constexpr double window(Window w, size_t n, size_t N)
+{
+    const double fac = -pi + n * (2.0 * pi / (N - 1)); // linspace(-pi, pi, N)
+    switch (w) {
+    case Window::COSINE:
+        return sine(pi / N * (n + 0.5));
+    case Window::HANN:
+        return 0.5 + 0.5 * cosine(fac);
+    case Window::HAMMING:
+        return 0.54 + 0.46 * cosine(fac);
+    default:
+        return 1.0;
+    }
+}
+
+/// The firwin2 frequency grid has 2^ceil(log2(N)) + 1 points.
+constexpr size_t grid_size(size_t N)
+{
+    size_t result = 1;
+    while (result < N) result *= 2;
+    return result;
+}
+
+/**
+ * Upper half-plane poles of the phase-normalized Bessel prototypes,
+ * scipy.signal.besselap(ORDER, 'phase').  The gain of these is 1.
+ */
+template <size_t ORDER>
+constexpr std::array<std::array<double, 2>, ORDER / 2> bessel_poles()
+{
+    static_assert(ORDER == 2 or ORDER == 4,
+        "Only the 2nd and 4th order Bessel prototypes are available");
+
+    if constexpr (ORDER == 2) {
+        return {{
+            {{-0.8660254037844384, 0.4999999999999999}},
+        }};
+    } else {
+        return {{
+            {{-0.6572111716718827, 0.830161435004873}},
+            {{-0.9047587967882447, 0.27091873300387465}},
+        }};
+    }
+}
+
+} // detail
+
+/**
+ * Windowed-sinc low-pass or high-pass FIR filter, normalized to unity
+ * gain at DC (low-pass) or Nyquist (high-pass).
+ *
+ * scipy.signal.firwin(N, cutoff, fs=sample_rate, window=w,
+ *     pass_zero=not highpass)
+ *
+ * @tparam N is the number of taps; it must be odd for a high-pass filter.
+ */
+template <size_t N>
+constexpr std::array<double, N> firwin(double cutoff, double sample_rate,
+    Window w = Window::HAMMING, bool highpass = false)
+{
+    const double nyquist = 0.5 * sample_rate;
+    const double c = cutoff / nyquist;
+    const double left = highpass ? c : 0.0;
+    const double right = highpass ? 1.0 : c;
+    const double alpha = 0.5 * (N - 1);
+
+    std::array<double, N> h{};
+    double scale = 0.0;
+    for (size_t n = 0; n != N; ++n) {
+        const double m = n - alpha;
+        h[n] = right * detail::sinc(right * m) - left * detail::sinc(left * m);
+        h[n] *= detail::window(w, n, N);
+        scale += h[n] * (highpass ? detail::cosine(detail::pi * m) : 1.0);
+    }
+    for (auto& tap : h) tap /= scale;
+    return h;
+}
+
+/**
+ * Frequency sampling FIR filter.  The gain is linearly interpolated
+ * between the points given; the first frequency must be 0 and the last
+ * must be the Nyquist frequency.
+ *
+ * scipy.signal.firwin2(N, freq, gain, fs=sample_rate, window=w)
+ *
+ * @tparam N is the number of taps.
+ * @tparam P is the number of frequency points.
+ */
+template <size_t N, size_t P>
+constexpr std::array<double, N> firwin2(const std::array<double, P>& freq,
+    const std::array<double, P>& gain, double sample_rate,
+    Window w = Window::HAMMING)
+{
+    constexpr size_t M = detail::grid_size(N);
+    const double nyquist = 0.5 * sample_rate;
+
+    std::array<double, M + 1> fx{};
+    size_t j = 0;
+    for (size_t k = 0; k != M + 1; ++k) {
+        const double x = k * (nyquist / M);
+        while (j + 2 < P and x > freq[j + 1]) ++j;
+        fx[k] = gain[j] + (x - freq[j]) * (gain[j + 1] - gain[j])
+            / (freq[j + 1] - freq[j]);
+    }
+
+    // The inverse real FFT of the gains, shifted to the middle tap, is
+    // a sum of cosines of multiples of pi / 2M.
+    std::array<double, 4 * M> cosines{};
+    for (size_t i = 0; i != 4 * M; ++i) {
+        cosines[i] = detail::cosine(detail::pi * i / (2 * M));
+    }
+
+    std::array<double, N> h{};
+    const double last = fx[M] * cosines[(N - 1) * M % (4 * M)];
+    for (size_t n = 0; n != N; ++n) {
+        const size_t step = 2 * n >= N - 1 ? 2 * n - (N - 1) : (N - 1) - 2 * n;
+        double sum = 0.0;
+        for (size_t k = 1; k != M; ++k) {
+            sum += fx[k] * cosines[k * step % (4 * M)];
+        }
+        h[n] = (fx[0] + (n % 2 ? -last : last) + 2.0 * sum) / (2 * M);
+        h[n] *= detail::window(w, n, N);
+    }
+    return h;
+}
+
+/**
+ * Bessel low-pass filter as second-order sections {b0, b1, b2, a1, a2},
+ * with the gain in the first section and the sections in order of
+ * increasing pole radius.
+ *
+ * scipy.signal.bessel(ORDER, cutoff, fs=sample_rate, output='sos')
+ */
+template <size_t ORDER>
+constexpr BiquadCoefficients<double, ORDER / 2> bessel(double cutoff,
+    double sample_rate)
+{
+    constexpr size_t SECTIONS = ORDER / 2;
+    constexpr auto poles = detail::bessel_poles<ORDER>();
+
+    // Pre-warp for the bilinear transform, with fs normalized to 2.
+    const double warped = 4.0 * detail::tangent(detail::pi * cutoff / sample_rate);
+
+    BiquadCoefficients<double, SECTIONS> result{};
+    double gain = 1.0;
+    for (size_t i = 0; i != SECTIONS; ++i) {
+        const double re = poles[i][0] * warped;
+        const double im = poles[i][1] * warped;
+
+        // z = (4 + p) / (4 - p)
+        const double dr = 4.0 - re;
+        const double den = dr * dr + im * im;
+        const double zr = ((4.0 + re) * dr - im * im) / den;
+        const double zi = (im * dr + (4.0 + re) * im) / den;
+
+        gain *= warped * warped / den;
+        result[i] = {{1.0, 2.0, 1.0, -2.0 * zr, zr * zr + zi * zi}};
+    }
+
+    for (size_t i = 0; i != SECTIONS; ++i) {
+        for (size_t j = i + 1; j != SECTIONS; ++j) {
+            if (result[j][4] < result[i][4]) {
+                const auto tmp = result[i];
+                result[i] = result[j];
+                result[j] = tmp;
+            }
+        }
+    }
+
+    for (size_t i = 0; i != 3; ++i) result[0][i] *= gain;
+    return result;
+}
+
+/// Drop K taps from each end.
+template <size_t K, typename T, size_t N>
+constexpr std::array<T, N - 2 * K> trim(const std::array<T, N>& h)
+{
+    std::array<T, N - 2 * K> result{};
+    for (size_t i = 0; i != N - 2 * K; ++i) result[i] = h[i + K];
+    return result;
+}
+
+template <typename T, size_t N>
+constexpr std::array<T, N> convert(const std::array<double, N>& h)
+{
+    std::array<T, N> result{};
+    for (size_t i = 0; i != N; ++i) result[i] = T(h[i]);
+    return result;
+}
+
+template <typename T, size_t N>
+constexpr BiquadCoefficients<T, N> convert(const BiquadCoefficients<double, N>& sos)
+{
+    BiquadCoefficients<T, N> result{};
+    for (size_t i = 0; i != N; ++i) result[i] = convert<T>(sos[i]);
+    return result;
+}
+
+/// Fixed-point taps, rounded; np.round(h * 2**FRACTION_BITS).
+template <typename T, int FRACTION_BITS, size_t N>
+constexpr std::array<T, N> quantize(const std::array<double, N>& h)
+{
+    std::array<T, N> result{};
+    for (size_t i = 0; i != N; ++i) {
+        const double scaled = h[i] * double(1LL << FRACTION_BITS);
+        result[i] = T(scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+    }
+    return result;
+}
+
+template <typename T, int FRACTION_BITS, size_t N>
+constexpr BiquadCoefficients<T, N> quantize(const BiquadCoefficients<double, N>& sos)
+{
+    BiquadCoefficients<T, N> result{};
+    for (size_t i = 0; i != N; ++i) {
+        result[i] = quantize<T, FRACTION_BITS>(sos[i]);
+    }
+    return result;
+}
+
+/// Fixed-point taps, truncated; np.array(h * 2**FRACTION_BITS, dtype=int).
+template <typename T, int FRACTION_BITS, size_t N>
+constexpr std::array<T, N> truncate(const std::array<double, N>& h)
+{
+    std::array<T, N> result{};
+    for (size_t i = 0; i != N; ++i) {
+        result[i] = T(h[i] * double(1LL << FRACTION_BITS));
+    }
+    return result;
+}
+
+/// A hash (FNV-1a) of integer taps, to compare with a known table.
+template <typename T, size_t N>
+constexpr uint32_t fingerprint(const T (&taps)[N])
+{
+    uint32_t result = 2166136261u;
+    for (auto tap : taps) {
+        result ^= uint32_t(int32_t(tap));
+        result *= 16777619u;
+    }
+    return result;
+}
+
+template <typename T, size_t N>
+constexpr uint32_t fingerprint(const std::array<T, N>& taps)
+{
+    uint32_t result = 2166136261u;
+    for (auto tap : taps) {
+        result ^= uint32_t(int32_t(tap));
+        result *= 16777619u;
+    }
+    return result;
+}
+
+constexpr bool near(double a, double b, double tolerance)
+{
+    return (a < b ? b - a : a - b) <= tolerance;
+}
+
+}}}} // mobilinkd::tnc::filter::design
+
+#endif // MOBILINKD__TNC__FILTER_DESIGN_HPP_
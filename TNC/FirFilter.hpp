@@ -8,7 +8,10 @@
 
 #include "arm_math.h"
 
+#include <algorithm>
+#include <iterator>
 #include <vector>
+#include <cassert>
 #include <cstdlib>
 
 namespace mobilinkd { namespace tnc {
@@ -18,6 +21,28 @@ struct TFirCoefficients {
     float taps[N];
 };
 
+/**
+ * Fixed-point FIR coefficients with FRACTION_BITS fractional bits.  These
+ * are created from the float coefficients at compile time with quantize().
+ */
+template <size_t N, int FRACTION_BITS>
+struct TFixedFirCoefficients {
+    static constexpr int fraction_bits = FRACTION_BITS;
+    int16_t taps[N];
+};
+
+template <int FRACTION_BITS, size_t N>
+constexpr TFixedFirCoefficients<N, FRACTION_BITS>
+quantize(const TFirCoefficients<N>& c)
+{
+    TFixedFirCoefficients<N, FRACTION_BITS> result{};
+    for (size_t i = 0; i != N; ++i) {
+        const float scaled = c.taps[i] * float(1 << FRACTION_BITS);
+        result.taps[i] = int16_t(scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+    }
+    return result;
+}
+
 struct FirCoefficients {
     size_t size;
     const float* taps;
@@ -134,6 +159,91 @@ struct Q15FirFilter {
     }
 };
 
+/**
+ * The input range of the filters that add the two samples sharing a tap
+ * with QADD16 before multiplying.  The sum of two inputs within
+ * +/-Q15_PREADD_LIMIT cannot saturate.
+ */
+constexpr int32_t Q15_PREADD_LIMIT = 16384;
+
+/**
+ * A Q15 FIR filter for linear-phase (symmetric) taps.  The samples that
+ * share a tap are added first, with QADD16, so each SMLAD does four taps.
+ * This is half the multiplies of arm_fir_fast_q15() and the result is the
+ * same, unless a pair of samples saturates when added.  Input must stay
+ * within +/-Q15_PREADD_LIMIT to guarantee identical results.
+ *
+ * When DECIMATION > 1 only every DECIMATION'th output is computed, the
+ * last of each group of DECIMATION input samples.
+ */
+template <size_t BLOCK_SIZE, size_t FILTER_SIZE, size_t DECIMATION = 1>
+struct Q15SymmetricFirFilter {
+
+    static_assert(BLOCK_SIZE % DECIMATION == 0,
+        "BLOCK_SIZE must be a multiple of DECIMATION");
+
+    static constexpr size_t OUTPUT_SIZE = BLOCK_SIZE / DECIMATION;
+    static constexpr size_t HALF_SIZE = FILTER_SIZE / 2;
+
+    const q15_t* filter_taps{nullptr};
+    q15_t filter_state[BLOCK_SIZE + FILTER_SIZE - 1];
+    q15_t filter_output[OUTPUT_SIZE];
+
+    Q15SymmetricFirFilter()
+    {}
+
+    Q15SymmetricFirFilter(const q15_t* taps)
+    {
+        init(taps);
+    }
+
+    void init(const q15_t* taps)
+    {
+        for (size_t i = 0; i != HALF_SIZE; i++) {
+            assert(taps[i] == taps[FILTER_SIZE - 1 - i]);
+        }
+        filter_taps = taps;
+        std::fill(std::begin(filter_state), std::end(filter_state), 0);
+    }
+
+    // ADC input
+    q15_t* operator()(const q15_t* input)
+    {
+        return filter(input);
+    }
+
+    /// Filter BLOCK_SIZE samples, returning OUTPUT_SIZE samples.
+    q15_t* filter(const q15_t* input)
+    {
+        std::copy(input, input + BLOCK_SIZE, filter_state + FILTER_SIZE - 1);
+
+        for (size_t i = 0; i != OUTPUT_SIZE; i++) {
+            const q15_t* x = filter_state + i * DECIMATION + DECIMATION - 1;
+            int32_t accum = 0;
+            size_t j = 0;
+            for (; j + 1 < HALF_SIZE; j += 2) {
+                // The back pair is in the opposite order; swap it.
+                uint32_t front = _SIMD32_OFFSET(x + j);
+                uint32_t back = __ROR(_SIMD32_OFFSET(x + FILTER_SIZE - 2 - j), 16);
+                accum = __SMLAD(__QADD16(front, back),
+                    _SIMD32_OFFSET(filter_taps + j), accum);
+            }
+            if (j != HALF_SIZE) {
+                accum += (int32_t(x[j]) + x[FILTER_SIZE - 1 - j]) * filter_taps[j];
+            }
+            if (FILTER_SIZE % 2) {
+                accum += int32_t(x[HALF_SIZE]) * filter_taps[HALF_SIZE];
+            }
+            filter_output[i] = __SSAT(accum >> 15, 16);
+        }
+
+        std::copy(filter_state + BLOCK_SIZE,
+            filter_state + BLOCK_SIZE + FILTER_SIZE - 1, filter_state);
+
+        return filter_output;
+    }
+};
+
 }} // mobilinkd::tnc
 
 #endif // MOBILINKD__TNC__FIR_FILTER_H_
@@ -0,0 +1,34 @@
+// Copyright 2019 Rob Riggs <rob@mobilinkd.com>
+// All rights reserved.
+
+#include "Fsk9600Demodulator.hpp"
+
+namespace mobilinkd { namespace tnc { namespace fsk9600 {
+
+Demodulator::result_type Demodulator::operator()(const q15_t* samples, size_t len)
+{
+    result_type result{};
+
+    hdlc_decoder_.fix_bits_budget = hdlc::FIX_BITS_TRIALS_PER_BLOCK;
+
+    auto* filtered = filter_(samples);
+
+    for (size_t i = 0; i != len; i++) {
+        bool bit = filtered[i] >= 0;
+        auto pll = pll_(bit);
+
+        if (pll.sample) {
+            locked_ = pll.locked;
+
+            if (not hdlc_bits_(nrzi_.decode(scrambler_.descramble(bit))))
+                continue;
+
+            // A block is under 18 bits; there can be only one frame.
+            auto frame = hdlc_decoder_(hdlc_bits_.byte());
+            if (frame) result[0] = frame;
+        }
+    }
+    return result;
+}
+
+}}} // mobilinkd::tnc::fsk9600
@@ -0,0 +1,100 @@
+// Copyright 2019 Rob Riggs <rob@mobilinkd.com>
+// All rights reserved.
+
+#ifndef MOBILINKD__TNC__FSK9600_DEMODULATOR_HPP_
+#define MOBILINKD__TNC__FSK9600_DEMODULATOR_HPP_
+
+#include <arm_math.h>
+#include "AudioInput.hpp"
+#include "DigitalPLL.hpp"
+#include "FilterDesign.hpp"
+#include "FirFilter.hpp"
+#include "G3RuhScrambler.hpp"
+#include "HdlcDecoder.hpp"
+#include "NRZI.hpp"
+
+#include <array>
+
+namespace mobilinkd { namespace tnc { namespace fsk9600 {
+
+constexpr const uint32_t SAMPLE_RATE = 48000;
+constexpr const uint32_t SYMBOL_RATE = 9600;
+
+/*
+ * The receive (matched) filter.  32 taps, 6kHz low-pass, Hamming window.
+ *
+ * np.round(firwin(32, 6000.0, fs=48000) * 32768)
+ */
+constexpr size_t MATCHED_FILTER_LEN = 32;
+
+constexpr auto matched_filter_coeffs = filter::design::quantize<q15_t, 15>(
+    filter::design::firwin<MATCHED_FILTER_LEN>(6000.0, SAMPLE_RATE));
+
+static_assert(SAMPLE_RATE != 48000
+    or filter::design::fingerprint(matched_filter_coeffs) == 0x0cf8733b,
+    "matched_filter_coeffs does not match the scipy design");
+
+typedef Q15SymmetricFirFilter<audio::ADC_BUFFER_SIZE, MATCHED_FILTER_LEN>
+    matched_filter_type;
+
+/**
+ * G3RUH 9600 baud demodulator.  The input is the flat (data port) audio,
+ * sampled at SAMPLE_RATE.  It is low-pass filtered, sliced at zero, and
+ * the clock recovery PLL picks one sample per bit.  The bits are
+ * descrambled, NRZI decoded and passed to the HDLC decoder.
+ *
+ * This has the same interface as the AFSK demodulators, with one branch.
+ */
+struct Demodulator
+{
+    typedef std::array<hdlc::IoFrame*, 1> result_type;
+    typedef FixedDigitalPLL DPLL;
+
+    matched_filter_type filter_;
+    DPLL pll_;
+    G3RuhScrambler scrambler_;
+    libafsk::NRZI nrzi_;
+    hdlc::BitPacker hdlc_bits_;
+    hdlc::NewDecoder hdlc_decoder_;
+    bool locked_;
+
+    Demodulator()
+    : pll_(SAMPLE_RATE, SYMBOL_RATE)
+    , nrzi_(), hdlc_decoder_(false), locked_(false)
+    {
+        filter_.init(matched_filter_coeffs.data());
+    }
+
+    // The filter instance points into the object; it must not be copied.
+    Demodulator(const Demodulator&) = delete;
+    Demodulator& operator=(const Demodulator&) = delete;
+
+    static constexpr size_t size() { return 1; }
+
+    /**
+     * Demodulate a block of samples.
+     *
+     * @param samples are DC-adjusted ADC samples.
+     * @param len must be ADC_BUFFER_SIZE.
+     * @return the decoded frame or nullptr.
+     */
+    result_type operator()(const q15_t* samples, size_t len);
+
+    /// Set the fix bits mode and reset its statistics.
+    void fix_bits(hdlc::FixBits mode)
+    {
+        hdlc_decoder_.fix_bits_mode = mode;
+        hdlc_decoder_.fix_bits_stats = hdlc::FixBitsStats();
+    }
+
+    hdlc::FixBitsStats fix_bits_stats() const
+    {
+        return hdlc_decoder_.fix_bits_stats;
+    }
+
+    bool locked() const {return locked_;}
+};
+
+}}} // mobilinkd::tnc::fsk9600
+
+#endif // MOBILINKD__TNC__FSK9600_DEMODULATOR_HPP_
@@ -0,0 +1,195 @@
+// Copyright 2019 Rob Riggs <rob@mobilinkd.com>
+// All rights reserved.
+
+#ifndef MOBILINKD__TNC__FSK9600_MODULATOR_HPP_
+#define MOBILINKD__TNC__FSK9600_MODULATOR_HPP_
+
+#include "Modulator.hpp"
+#include "G3RuhScrambler.hpp"
+#include "PTT.hpp"
+
+#include "stm32l4xx_hal.h"
+#include "cmsis_os.h"
+
+#include <algorithm>
+
+extern DAC_HandleTypeDef hdac1;
+
+namespace mobilinkd { namespace tnc {
+
+/*
+ * Raised cosine (alpha = 1.0) pulse shaping for the G3RUH modem.  Each
+ * bit is SAMPLES_PER_BIT DAC samples, which depend on the previous, the
+ * current and the next bit (bits 2, 1 and 0 of the index; 1 is +1).
+ *
+ * p = lambda t: np.sinc(t) * np.cos(np.pi * t) / (1 - 4 * t**2)
+ * [[round(2047 / 1.1 * sum(b * p((k + 0.5) / 5 - 0.5 - d)
+ *     for b, d in zip(bits(w), (-1, 0, 1)))) for k in range(5)]
+ *     for w in range(8)]
+ */
+const int16_t fsk9600_shape[8][5] = {
+    {-1850, -1853, -1861, -1853, -1850},
+    {-1887, -1952, -1861, -1402,  -531},
+    {  568,  1500,  1861,  1500,   568},
+    {  531,  1402,  1861,  1952,  1887},
+    { -531, -1402, -1861, -1952, -1887},
+    { -568, -1500, -1861, -1500,  -568},
+    { 1887,  1952,  1861,  1402,   531},
+    { 1850,  1853,  1861,  1853,  1850},
+};
+
+/**
+ * G3RUH 9600 baud modulator.  The NRZI encoded bits from the HDLC encoder
+ * are scrambled and queued 8 at a time, so that each DMA half-transfer
+ * sends a byte rather than a bit.  The output lags the input by one bit
+ * because each bit's shape depends on the next bit.  flush() pads the
+ * last word so that every bit is sent.
+ *
+ * The scrambled bits waiting to be queued belong to the encoder's task;
+ * the DAC callbacks only use window_.
+ *
+ * This needs a radio with a flat (data port) audio path.
+ */
+struct Fsk9600Modulator : Modulator
+{
+    static const uint32_t SAMPLE_RATE = 48000;
+    static const uint32_t BIT_RATE = 9600;
+    static const size_t SAMPLES_PER_BIT = SAMPLE_RATE / BIT_RATE;
+    static const size_t BITS_PER_FILL = 8;
+    static const size_t FILL_LEN = BITS_PER_FILL * SAMPLES_PER_BIT;
+    static const size_t DAC_BUFFER_LEN = FILL_LEN * 2;
+
+    int running_{-1};
+    osMessageQId dacOutputQueueHandle_;
+    PTT* ptt_;
+    uint16_t volume_{4096};
+    G3RuhScrambler scrambler_;
+    uint32_t bits_{0};          ///< Scrambled bits waiting to be queued.
+    size_t count_{0};
+    bool last_{false};          ///< The last bit from the encoder.
+    uint8_t window_{0};         ///< The last 3 bits sent, newest in bit 0.
+    uint16_t buffer_[DAC_BUFFER_LEN];
+
+    Fsk9600Modulator(osMessageQId queue, PTT* ptt)
+    : dacOutputQueueHandle_(queue), ptt_(ptt)
+    {
+        std::fill(buffer_, buffer_ + DAC_BUFFER_LEN, 2048);
+    }
+
+    void set_volume(uint16_t v)
+    {
+        v = std::max<uint16_t>(256, v);
+        v = std::min<uint16_t>(4096, v);
+        volume_ = v;
+    }
+
+    void set_ptt(PTT* ptt) {
+        if (ptt == ptt_) return;  // No change.
+        auto old = ptt_;
+        ptt_ = ptt;
+        old->off();
+        if (running_ == 1) {
+            ptt_->on();
+        }
+    }
+
+    uint32_t bit_rate() const {return BIT_RATE;}
+
+    bool idle() const {return running_ == -1;}
+
+    void send(bool bit) {
+        last_ = bit;
+        bits_ |= uint32_t(scrambler_.scramble(bit)) << count_;
+        if (++count_ != BITS_PER_FILL) return;
+
+        uint32_t value = bits_;
+        bits_ = 0;
+        count_ = 0;
+
+        switch (running_) {
+        case -1:
+            fill_first(value);
+            running_ = 0;
+            break;
+        case 0:
+            fill_last(value);
+            running_ = 1;
+            ptt_->on();
+            set_sample_rate(SAMPLE_RATE);
+            HAL_TIM_Base_Start(&htim7);
+            HAL_DAC_Start_DMA(&hdac1, DAC_CHANNEL_1, (uint32_t*) buffer_, DAC_BUFFER_LEN, DAC_ALIGN_12B_R);
+            break;
+        case 1:
+            osMessagePut(dacOutputQueueHandle_, value, osWaitForever);
+            break;
+        }
+    }
+
+    /**
+     * Pad the bits waiting to be queued with copies of the last bit (NRZI
+     * ones) and queue them.  At least one bit is added, so that the last
+     * bit from the encoder is shaped and sent.
+     */
+    void flush() {
+        do {
+            send(last_);
+        } while (count_ != 0);
+    }
+
+    /// Fill FILL_LEN samples with BITS_PER_FILL bits, LSB first.
+    void fill(uint16_t* buffer, uint32_t bits) {
+        for (size_t i = 0; i != BITS_PER_FILL; i++) {
+            window_ = ((window_ << 1) | (bits & 1)) & 7;
+            bits >>= 1;
+            for (auto s : fsk9600_shape[window_]) {
+                *buffer++ = uint16_t(((s * volume_) >> 12) + 2048);
+            }
+        }
+    }
+
+    void fill_first(uint32_t bits) {
+        fill(buffer_, bits);
+    }
+
+    void fill_last(uint32_t bits) {
+        fill(buffer_ + FILL_LEN, bits);
+    }
+
+    void empty() {
+        switch (running_) {
+        case 1:
+            running_ = 0;
+            break;
+        case 0:
+            stop();
+            break;
+        case -1:
+            break;
+        }
+    }
+
+    /**
+     * Stop sending.  This is also called from the DAC underrun interrupt,
+     * so it leaves any bits waiting to be queued for flush().
+     */
+    void abort() {
+        stop();
+
+        // Drain the queue.
+        while (osMessageGet(dacOutputQueueHandle_, 0).status == osEventMessage);
+    }
+
+private:
+
+    void stop() {
+        running_ = -1;
+        HAL_DAC_Stop_DMA(&hdac1, DAC_CHANNEL_1);
+        HAL_TIM_Base_Stop(&htim7);
+        ptt_->off();
+        window_ = 0;
+    }
+};
+
+}} // mobilinkd::tnc
+
+#endif // MOBILINKD__TNC__FSK9600_MODULATOR_HPP_
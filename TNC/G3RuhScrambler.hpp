@@ -0,0 +1,47 @@
+// Copyright 2019 Rob Riggs <rob@mobilinkd.com>
+// All rights reserved.
+
+#ifndef MOBILINKD__TNC__G3RUH_SCRAMBLER_HPP_
+#define MOBILINKD__TNC__G3RUH_SCRAMBLER_HPP_
+
+#include <cstdint>
+
+namespace mobilinkd { namespace tnc {
+
+/**
+ * The self-synchronizing scrambler used by the G3RUH 9600 baud modem,
+ * x^17 + x^12 + 1.  The transmitter scrambles the NRZI encoded bits; the
+ * receiver descrambles them before NRZI decoding.  The descrambler syncs
+ * up after 17 bits.
+ */
+struct G3RuhScrambler
+{
+    uint32_t state_{0};
+
+    bool scramble(bool bit)
+    {
+        bool result = bit ^ tap();
+        state_ = (state_ << 1) | result;
+        return result;
+    }
+
+    bool descramble(bool bit)
+    {
+        bool result = bit ^ tap();
+        state_ = (state_ << 1) | bit;
+        return result;
+    }
+
+    void reset() { state_ = 0; }
+
+private:
+
+    bool tap() const
+    {
+        return ((state_ >> 11) ^ (state_ >> 16)) & 1;
+    }
+};
+
+}} // mobilinkd::tnc
+
+#endif // MOBILINKD__TNC__G3RUH_SCRAMBLER_HPP_
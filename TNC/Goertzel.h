@@ -6,6 +6,7 @@
 
 #include "AudioLevel.hpp"
 #include <arm_math.h>
+#include <array>
 #include <complex>
 
 namespace mobilinkd { namespace tnc {
@@ -42,7 +43,7 @@ public:
 	  }
 	}
 	
-  void operator()(uint16_t* samples, uint32_t n) {
+  void operator()(const uint16_t* samples, uint32_t n) {
 
     for (uint32_t i = 0; i != n; ++i) {
         float w = window_ ? window_[count] : 1.0;
@@ -65,6 +66,72 @@ public:
   }
 };
 
+/**
+ * N Goertzel filters over the same samples.  Each sample is converted and
+ * windowed once for all of the bins, rather than once per filter as with
+ * N GoertzelFilters.  The results are those of GoertzelFilters with the
+ * same frequencies and window, to within float rounding.
+ *
+ * @tparam N is the number of bins.
+ * @tparam SAMPLES is the number of samples between resets.
+ */
+template <size_t N, uint32_t SAMPLES, uint32_t SAMPLE_RATE>
+class GoertzelBank
+{
+  std::array<float, N> coeff_;
+  std::array<float, N> d1_;
+  std::array<float, N> d2_;
+  uint32_t count_{0};
+  const float* window_;
+
+  template <typename F>
+  void run(uint32_t n, F sample) {
+
+    for (uint32_t i = 0; i != n; ++i) {
+        float x = window_ ? window_[count_] * sample(i) : sample(i);
+        for (size_t j = 0; j != N; ++j) {
+            float y = x + coeff_[j] * d1_[j] - d2_[j];
+            d2_[j] = d1_[j];
+            d1_[j] = y;
+        }
+        ++count_;
+    }
+  }
+
+public:
+  GoertzelBank(const std::array<float, N>& freqs, const float* window = WINDOW)
+  : coeff_(), d1_(), d2_(), window_(window)
+  {
+    for (size_t j = 0; j != N; ++j) {
+      int bin = 0.5f + ((freqs[j] * SAMPLES) / SAMPLE_RATE);
+      coeff_[j] = 2.0f * cos((2.0f * M_PI * bin) / float(SAMPLES));
+    }
+  }
+
+  void operator()(const uint16_t* samples, uint32_t n) {
+    run(n, [samples](uint32_t i) {
+      return (float(samples[i]) - audio::virtual_ground) * audio::i_vgnd;
+    });
+  }
+
+  void operator()(const q15_t* samples, uint32_t n) {
+    run(n, [samples](uint32_t i) { return float(samples[i]); });
+  }
+
+  /// The energy in bin j.
+  float operator[](size_t j) const {
+    return d2_[j] * d2_[j] + d1_[j] * d1_[j] - coeff_[j] * d1_[j] * d2_[j];
+  }
+
+  static constexpr size_t size() { return N; }
+
+  void reset() {
+    d1_.fill(0.0f);
+    d2_.fill(0.0f);
+    count_ = 0;
+  }
+};
+
 #if 0
 template <uint32_t SAMPLES, uint32_t SAMPLE_RATE>
 class GoertzelFactory
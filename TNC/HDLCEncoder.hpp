@@ -4,7 +4,7 @@
 #ifndef INC_HDLCENCODER_HPP_
 #define INC_HDLCENCODER_HPP_
 
-#include "AFSKModulator.hpp"
+#include "Modulator.hpp"
 #include "HdlcFrame.hpp"
 #include "NRZI.hpp"
 #include "PTT.hpp"
@@ -28,6 +28,21 @@ struct Encoder {
     static const uint8_t IDLE = 0x00;
     static const uint8_t FLAG = 0x7E;
 
+    /**
+     * Signals sent to the modulator task.  FRAME_SIGNAL is set when a frame
+     * is put on the input queue and UPDATE_SIGNAL to have the encoder call
+     * the update function once the frames queued are sent and the modulator
+     * is idle.  The update function returns the modulator to use from then
+     * on.  The DAC callbacks set IDLE_SIGNAL when the modulator stops.
+     */
+    static const int32_t FRAME_SIGNAL = 1;
+    static const int32_t UPDATE_SIGNAL = 2;
+    static const int32_t IDLE_SIGNAL = 4;
+    typedef Modulator* (*update_type)();
+
+    /// How long to wait for the modulator to finish sending, in ms.
+    static const uint32_t IDLE_TIMEOUT = 1000;
+
     enum class state_type {
         STATE_IDLE,
         STATE_HEAD,
@@ -47,11 +62,12 @@ struct Encoder {
     NRZI nrzi_;
     uint16_t crc_;
     osMessageQId input_;
-    AFSKModulator* modulator_;
+    Modulator* modulator_;
+    update_type update_{nullptr};
     volatile bool running_;
     bool send_delay_;   // Avoid sending the preamble for back-to-back frames.
 
-    Encoder(osMessageQId input, AFSKModulator* output)
+    Encoder(osMessageQId input, Modulator* output)
     : tx_delay_(kiss::settings().txdelay), tx_tail_(kiss::settings().txtail)
     , p_persist_(kiss::settings().ppersist), slot_time_(kiss::settings().slot)
     , duplex_(kiss::settings().duplex), state_(state_type::STATE_IDLE)
@@ -63,9 +79,10 @@ struct Encoder {
     void run() {
         running_ = true;
         send_delay_ = true;
+        bool update = false;
         while (running_) {
             state_ = state_type::STATE_IDLE;
-            osEvent evt = osMessageGet(input_, osWaitForever);
+            osEvent evt = osMessageGet(input_, 0);
             if (evt.status == osEventMessage) {
                 auto frame = (IoFrame*) evt.value.p;
                 process(frame);
@@ -73,12 +90,24 @@ struct Encoder {
                 evt = osMessagePeek(input_, 0);
                 if (evt.status != osEventMessage) {
                     send_raw(IDLE);
+                    modulator_->flush();
                     send_delay_ = true;
                     if (!duplex_) {
                       osMessagePut(audioInputQueueHandle, audio::DEMODULATOR,
                         osWaitForever);
                     }
                 }
+                continue;
+            }
+            // The frames queued before the update are sent first.
+            if (update) {
+                update = false;
+                update_modulator();
+                continue;
+            }
+            evt = osSignalWait(FRAME_SIGNAL | UPDATE_SIGNAL, osWaitForever);
+            if (evt.status == osEventSignal) {
+                update = evt.value.signals & UPDATE_SIGNAL;
             }
         }
     }
@@ -95,6 +124,26 @@ struct Encoder {
     int p_persist() const { return p_persist_; }
     void p_persist(int value) { p_persist_ = value; }
 
+    void modulator(Modulator* output) { modulator_ = output; }
+
+    void on_update(update_type update) { update_ = update; }
+
+    /**
+     * Let the modulator send what it has queued, then hand over to the
+     * update function.  Only the modulator task may change the modulator
+     * or its settings while it is sending.
+     */
+    void update_modulator() {
+        if (not update_) return;
+        uint32_t start = osKernelSysTick();
+        while (not modulator_->idle()) {
+            uint32_t elapsed = osKernelSysTick() - start;
+            if (elapsed >= IDLE_TIMEOUT) break;
+            osSignalWait(IDLE_SIGNAL, IDLE_TIMEOUT - elapsed);
+        }
+        modulator_ = update_();
+    }
+
     state_type status() const {return state_; }
     void stop() { running_ = false; }
 
@@ -191,8 +240,9 @@ struct Encoder {
         send_tail();
     }
 
+    // tx_delay_ is in 10ms units; send that many bytes of IDLE.
     void send_delay() {
-        const size_t tmp = (tx_delay_ * 3) / 2;
+        const size_t tmp = (tx_delay_ * modulator_->bit_rate()) / 800;
         for (size_t i = 0; i != tmp; i++) {
             send_raw(IDLE);
         }
@@ -5,6 +5,8 @@
 #include "GPIO.hpp"
 #include "Log.h"
 
+#include <array>
+
 namespace mobilinkd { namespace tnc { namespace hdlc {
 
 Decoder::Decoder(bool pass_all)
@@ -50,10 +52,14 @@ IoFrame* Decoder::operator()(bool bit, bool pll)
 }
 
 NewDecoder::optional_result_type NewDecoder::operator()(bool input, bool pll_lock)
+{
+    return complete(process(input, pll_lock));
+}
+
+NewDecoder::optional_result_type NewDecoder::complete(uint8_t status)
 {
     optional_result_type result = nullptr;
 
-    auto status = process(input, pll_lock);
     if (status)
     {
 //        INFO("Frame Status = %02x, size = %d, CRC = %04x",
@@ -62,6 +68,10 @@ NewDecoder::optional_result_type NewDecoder::operator()(bool input, bool pll_loc
         {
             result = packet;
             packet = nullptr;
+        } else if ((status & STATUS_CRC_ERROR) && packet->size() > 10
+            && fix_bits_mode != FixBits::NONE && fix_bits()) {
+            result = packet;
+            packet = nullptr;
         } else {
             packet->clear();
         }
@@ -70,6 +80,214 @@ NewDecoder::optional_result_type NewDecoder::operator()(bool input, bool pll_loc
     return result;
 }
 
+namespace {
+
+/// Shift a zero bit through the (bit-reversed) CRC-CCITT register.
+inline uint16_t crc_step(uint16_t crc)
+{
+    return (crc & 1) ? (crc >> 1) ^ 0x8408 : (crc >> 1);
+}
+
+void flip_bit(IoFrame* frame, size_t bit)
+{
+    auto it = frame->begin();
+    std::advance(it, bit / 8);
+    *it ^= (1 << (bit % 8));
+}
+
+/**
+ * The address field of an AX.25 frame is 2 to 10 addresses of 7 bytes.
+ * The callsign characters are upper case letters, digits or spaces shifted
+ * left one bit.  The low bit of the SSID byte is set in the last address
+ * and clear elsewhere.  A frame "fixed" by chance is unlikely to pass.
+ */
+bool ax25_address_ok(IoFrame* frame)
+{
+    const size_t size = frame->size() - 2;  // Without the FCS.
+    auto it = frame->begin();
+
+    for (size_t i = 0; i != size and i != 70; ++i, ++it) {
+        uint8_t c = *it;
+        if (i % 7 == 6) {
+            if (c & 1) return i >= 13 and i + 1 < size;
+        } else {
+            if (c & 1) return false;
+            c >>= 1;
+            if (not ((c >= 'A' and c <= 'Z') or (c >= '0' and c <= '9')
+                or c == ' ')) return false;
+        }
+    }
+    return false;
+}
+
+/**
+ * One 8-bit step of NewDecoder::process() between flags.  The step stops
+ * before a bit that follows five ones; that bit starts a flag or an
+ * abort.  A zero that follows five ones is dropped.
+ */
+struct DeframeStep
+{
+    uint8_t data;       ///< The destuffed bits, the first in bit 0.
+    uint8_t count;      ///< The number of destuffed bits.
+    uint8_t used;       ///< The number of input bits used (8 if no stop).
+    uint8_t ones;       ///< The ones count after the step, or ADD_ONES.
+};
+
+/// The ones count increases by 8 (all ones, from more than five).
+constexpr uint8_t ADD_ONES = 0xFF;
+
+/// The ones count at the start of a step: 0-5, or 6 for more than five.
+constexpr size_t RUN_STATES = 7;
+
+typedef std::array<std::array<DeframeStep, 256>, RUN_STATES> deframe_table_type;
+
+constexpr deframe_table_type make_deframe_table()
+{
+    deframe_table_type table{};
+
+    for (size_t run = 0; run != RUN_STATES; ++run) {
+        for (size_t input = 0; input != 256; ++input) {
+            DeframeStep step{0, 0, 8, 0};
+            size_t ones = run;
+            bool zero = false;
+            for (uint8_t i = 0; i != 8; ++i) {
+                const bool bit = (input >> i) & 1;
+                if (ones == 5) {
+                    if (bit) {
+                        step.used = i;  // Flag or abort.
+                        break;
+                    }
+                    ones = 0;           // Bit stuffing.
+                    zero = true;
+                    continue;
+                }
+                step.data |= bit << step.count;
+                ++step.count;
+                if (bit) {
+                    if (ones != 6) ++ones;
+                } else {
+                    ones = 0;
+                    zero = true;
+                }
+            }
+            step.ones = zero or run != 6 ? ones : ADD_ONES;
+            table[run][input] = step;
+        }
+    }
+    return table;
+}
+
+constexpr deframe_table_type deframe_table = make_deframe_table();
+
+} // namespace
+
+NewDecoder::optional_result_type NewDecoder::operator()(uint8_t input)
+{
+    while (packet == nullptr) {
+        packet = ioFramePool().acquire();
+        if (!packet) osThreadYield();
+    }
+
+    size_t used = 0;
+
+    // The ones count is kept exactly, as process() does.  Near 255 it
+    // could wrap back to five within this byte.
+    if (not flag and ones <= 255 - 8) {
+        const auto& step = deframe_table[ones < 6 ? ones : 6][input];
+
+        // Shift the destuffed bits into the buffer, and push the buffer
+        // when its 8th bit arrives, as process() does one bit at a time.
+        const uint16_t window = buffer | (uint16_t(step.data) << 8);
+        uint8_t total = bits + step.count;
+        if (state != State::IDLE and bits < 8 and total >= 8) {
+            packet->push_back(uint8_t(window >> (8 - bits)));
+            state = State::RECEIVE;
+            total -= 8;
+        }
+        buffer = uint8_t(window >> step.count);
+        bits = total;
+        ones = step.ones == ADD_ONES ? ones + 8 : step.ones;
+        used = step.used;
+    }
+
+    // There are not enough bits in a byte for more than one frame.
+    optional_result_type result = nullptr;
+    for (size_t i = used; i != 8; ++i) {
+        auto frame = complete(process((input >> i) & 1, true));
+        if (frame) result = frame;
+    }
+    return result;
+}
+
+bool NewDecoder::fix_bits()
+{
+    const size_t bits = packet->size() * 8;
+    const size_t trials = fix_bits_mode == FixBits::ADJACENT ? bits * 2 : bits;
+
+    if (trials > fix_bits_budget) {
+        ++fix_bits_stats.skipped;
+        return false;
+    }
+
+    // The CRC register after a bad frame is the CRC of the good frame
+    // XOR the CRC of the error pattern.  crc() is the register inverted.
+    const uint16_t syndrome = (packet->crc() ^ 0xFFFF) ^ VALID_CRC;
+
+    // Error CRC for each bit position, starting at the last bit.  The
+    // CRC-CCITT period is 32767 bits, longer than any frame, so there is
+    // at most one match.
+    uint16_t crc = 1;
+    size_t bit = bits;
+    while (bit != 0) {
+        --bit;
+        crc = crc_step(crc);
+        if (crc == syndrome) break;
+    }
+    fix_bits_budget -= bits - bit;
+
+    if (crc == syndrome) {
+        flip_bit(packet, bit);
+        packet->parse_fcs();
+        if (packet->ok() and ax25_address_ok(packet)) {
+            ++fix_bits_stats.single;
+            return true;
+        }
+        ++fix_bits_stats.rejected;
+        return false;
+    }
+
+    if (fix_bits_mode != FixBits::ADJACENT) {
+        ++fix_bits_stats.failed;
+        return false;
+    }
+
+    uint16_t next = 1;
+    crc = crc_step(next);
+    bit = bits - 1;
+    while (bit != 0) {
+        --bit;
+        next = crc;
+        crc = crc_step(crc);
+        if ((crc ^ next) == syndrome) break;
+    }
+    fix_bits_budget -= bits - bit;
+
+    if ((crc ^ next) == syndrome) {
+        flip_bit(packet, bit);
+        flip_bit(packet, bit + 1);
+        packet->parse_fcs();
+        if (packet->ok() and ax25_address_ok(packet)) {
+            ++fix_bits_stats.adjacent;
+            return true;
+        }
+        ++fix_bits_stats.rejected;
+        return false;
+    }
+
+    ++fix_bits_stats.failed;
+    return false;
+}
+
 uint8_t NewDecoder::process(bool input, bool pll_lock)
 {
     uint8_t result_code = 0;
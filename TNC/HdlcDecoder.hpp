@@ -324,6 +324,43 @@ IoFrame* Decoder::operator()(bool bit, bool pll)
 #endif
 
 
+/**
+ * How hard NewDecoder tries to fix frames that fail the CRC check.
+ */
+enum class FixBits : uint8_t {
+    NONE,           ///< Drop frames with a bad CRC.
+    SINGLE,         ///< Try flipping each bit.
+    ADJACENT        ///< Try flipping each bit, then each pair of adjacent bits.
+};
+
+/*
+ * The number of fix bits trials (see NewDecoder::fix_bits()) allowed per
+ * block, shared by all demodulator branches.  Each trial is one step of
+ * the CRC register.  This is enough to try single and adjacent bit flips
+ * on one 256-byte frame.
+ */
+const uint32_t FIX_BITS_TRIALS_PER_BLOCK = 4096;
+
+/// Counts of the frames that FixBits was applied to.
+struct FixBitsStats
+{
+    uint32_t single{0};     ///< Fixed by flipping one bit.
+    uint32_t adjacent{0};   ///< Fixed by flipping two adjacent bits.
+    uint32_t rejected{0};   ///< CRC fixed but the AX.25 address is invalid.
+    uint32_t failed{0};     ///< No single or adjacent flip fixes the CRC.
+    uint32_t skipped{0};    ///< Not enough trials left in the budget.
+
+    FixBitsStats& operator+=(const FixBitsStats& other)
+    {
+        single += other.single;
+        adjacent += other.adjacent;
+        rejected += other.rejected;
+        failed += other.failed;
+        skipped += other.skipped;
+        return *this;
+    }
+};
+
 struct NewDecoder
 {
     enum class State {IDLE, SYNC, RECEIVE};
@@ -351,12 +388,67 @@ struct NewDecoder
 
     frame_type* packet{nullptr};
 
+    FixBits fix_bits_mode{FixBits::NONE};
+    uint32_t fix_bits_budget{0};    ///< Trials left; the caller refills it.
+    FixBitsStats fix_bits_stats;
+
     NewDecoder(bool pass_all=false)
     : passall(pass_all)
     {}
 
     optional_result_type operator()(bool input, bool pll_lock);
+
+    /**
+     * Decode 8 bits with the PLL locked, the first bit in bit 0.  This
+     * gives the same frames as 8 calls of operator()(bit, true).
+     *
+     * The bits between flags are destuffed and added to the frame with
+     * one lookup in a table of 8-bit steps.  From the sixth one of a run,
+     * which starts a flag or an abort, the rest of the byte is passed to
+     * process() one bit at a time.
+     */
+    optional_result_type operator()(uint8_t input);
+
     uint8_t process(bool input, bool pll_lock);
+
+    /// Return or clear the packet after process() returns a status.
+    optional_result_type complete(uint8_t status);
+
+    /**
+     * Try to fix a packet that failed the CRC check by flipping one bit,
+     * then (in ADJACENT mode) two adjacent bits.  A single bit error in
+     * the NRZI encoded bit stream flips two adjacent data bits.
+     *
+     * The CRC of a flipped bit depends only on its distance from the end
+     * of the frame, so the CRC for each trial is found with one step of
+     * the CRC register rather than recomputing the CRC of the frame.
+     * Each trial costs one unit of fix_bits_budget.
+     *
+     * @return true if the packet was fixed.
+     */
+    bool fix_bits();
+};
+
+/**
+ * Packs the bits from the PLL into bytes for NewDecoder, the first bit
+ * in bit 0.  Frames are returned up to 7 bits later than they would be
+ * one bit at a time.
+ */
+struct BitPacker
+{
+    uint8_t byte_{0};
+    uint8_t count_{0};
+
+    /// @return true when a byte is complete.
+    bool operator()(bool bit)
+    {
+        byte_ = (byte_ >> 1) | (bit << 7);
+        if (++count_ != 8) return false;
+        count_ = 0;
+        return true;
+    }
+
+    uint8_t byte() const { return byte_; }
 };
 
 }}} // mobilinkd::tnc::hdlc
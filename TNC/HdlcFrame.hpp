@@ -70,7 +70,7 @@ private:
 
         checksum ^= 0xFFFF;  // Compliment
         checksum <<= 16;     // Shift
-        asm volatile("rbit %0, %0" : "+r" (checksum)); // Reverse
+        checksum = __RBIT(checksum);  // Reverse
         uint16_t result = checksum & 0xFFFF;
         DEBUG("CRC = %hx", result);
         return result;
@@ -128,6 +128,11 @@ public:
     }
 
     void parse_fcs() {              // RX frames have the checksums parsed.
+        if (data_.size() < 2) {     // Too short to have a checksum.
+            crc_ = -1;
+            complete_ = true;
+            return;
+        }
         auto it = data_.begin();
         std::advance(it, data_.size() - 2);
         fcs_ = (*it);
@@ -24,7 +24,6 @@
 #include "usbd_core.h"
 #include "cmsis_os.h"
 
-extern osMessageQId hdlcOutputQueueHandle;
 extern PCD_HandleTypeDef hpcd_USB_FS;
 extern osTimerId usbShutdownTimerHandle;
 
@@ -347,9 +346,7 @@ void startIOEventTask(void const*)
             if ((frame->type() & 0x0F) == IoFrame::DATA)
             {
             	kiss::getAFSKTestTone().stop();
-                if (osMessagePut(hdlcOutputQueueHandle,
-                    reinterpret_cast<uint32_t>(frame),
-                    osWaitForever) != osOK)
+                if (not sendFrame(frame))
                 {
                     ERROR("Failed to write frame to TX queue");
                     hdlc::release(frame);
@@ -362,9 +359,7 @@ void startIOEventTask(void const*)
             break;
         case IoFrame::DIGI_DATA:
             DEBUG("Digi frame");
-            if (osMessagePut(hdlcOutputQueueHandle,
-                reinterpret_cast<uint32_t>(frame),
-                osWaitForever) != osOK)
+            if (not sendFrame(frame))
             {
                 hdlc::release(frame);
             }
@@ -0,0 +1,135 @@
+// Copyright 2019 Rob Riggs <rob@mobilinkd.com>
+// All rights reserved.
+
+#ifndef MOBILINKD__TNC__INPUT_MONITOR_HPP_
+#define MOBILINKD__TNC__INPUT_MONITOR_HPP_
+
+#include "Goertzel.h"
+#include "LevelMeter.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace mobilinkd { namespace tnc {
+
+/**
+ * Input level and twist statistics, taken from the ADC blocks that the
+ * demodulator is already reading.  This lets the level and twist polls
+ * be answered without stopping the demodulator.
+ *
+ * The levels are measured all the time, as readLevels() does, over
+ * LEVEL_SAMPLES samples.  They are from the last complete window, or from
+ * the window in progress before the first one completes.
+ *
+ * The twist is only measured when it is asked for (start_twist()), as
+ * pollInputTwist() does: the average mark and space energy in dB over
+ * TWIST_PIECES pieces of TWIST_SIZE samples.  It is a measure of the
+ * noise on an empty channel, so blocks received with a carrier are
+ * skipped.  The twist filters are for the AFSK sample rate.  With other
+ * sample rates only the levels are measured.
+ *
+ * @tparam TWIST_SIZE is the Goertzel filter length.
+ */
+template <uint32_t TWIST_SIZE, uint32_t SAMPLE_RATE>
+struct InputMonitor
+{
+    static constexpr uint32_t LEVEL_SAMPLES = 2640;
+    static constexpr uint32_t TWIST_PIECES = 100;
+
+    LevelMeter meter_;
+    LevelMeter levels_;
+    GoertzelBank<2, TWIST_SIZE, SAMPLE_RATE> twist_{{1200.0, 2200.0}};
+    float mark_sum_{0.0f};
+    float space_sum_{0.0f};
+    uint32_t pieces_{0};
+    bool measuring_{false};
+    bool twist_enabled_{true};
+
+    /// @param twist is false to measure only the levels.
+    void reset(bool twist = true)
+    {
+        twist_enabled_ = twist;
+        meter_.reset();
+        levels_.reset();
+        mark_sum_ = 0.0f;
+        space_sum_ = 0.0f;
+        pieces_ = 0;
+        measuring_ = false;
+    }
+
+    /// Start a twist measurement, unless one is in progress.
+    void start_twist()
+    {
+        if (measuring_ or not twist_enabled_) return;
+        twist_.reset();
+        mark_sum_ = 0.0f;
+        space_sum_ = 0.0f;
+        pieces_ = 0;
+        measuring_ = true;
+    }
+
+    /// Stop measuring the twist.  mark() and space() keep the result.
+    void stop_twist()
+    {
+        measuring_ = false;
+    }
+
+    /// True once the measurement in progress has TWIST_PIECES pieces.
+    bool twist_complete() const
+    {
+        return measuring_ and pieces_ == TWIST_PIECES;
+    }
+
+    /**
+     * Add a block of raw ADC samples.
+     *
+     * @param n must be a multiple of TWIST_SIZE.
+     * @param carrier is true if the block is not from an empty channel;
+     *  it is not used for the twist.
+     * @return true if a level window was completed.
+     */
+    bool operator()(const uint16_t* samples, size_t n, bool carrier = false)
+    {
+        bool result = false;
+        meter_(samples, n);
+        if (meter_.count() >= LEVEL_SAMPLES) {
+            levels_ = meter_;
+            meter_.reset();
+            result = true;
+        }
+
+        if (not measuring_ or carrier) return result;
+
+        for (size_t i = 0; i != n and pieces_ != TWIST_PIECES; i += TWIST_SIZE) {
+            twist_(samples + i, TWIST_SIZE);
+            mark_sum_ += 10.0f * log10f(twist_[0]);
+            space_sum_ += 10.0f * log10f(twist_[1]);
+            twist_.reset();
+            ++pieces_;
+        }
+        return result;
+    }
+
+    /// The levels, as readLevels() measures them.
+    const LevelMeter& levels() const
+    {
+        return levels_.count() ? levels_ : meter_;
+    }
+
+    /// The average mark (1200Hz) energy in dB, or 0 if none was measured.
+    float mark() const
+    {
+        return pieces_ ? mark_sum_ / pieces_ : 0.0f;
+    }
+
+    /// The average space (2200Hz) energy in dB, or 0 if none was measured.
+    float space() const
+    {
+        return pieces_ ? space_sum_ / pieces_ : 0.0f;
+    }
+};
+
+}} // mobilinkd::tnc
+
+#endif // MOBILINKD__TNC__INPUT_MONITOR_HPP_
@@ -0,0 +1,140 @@
+// Copyright 2019 Rob Riggs <rob@mobilinkd.com>
+// All rights reserved.
+
+#ifndef MOBILINKD__TNC__INPUT_TRACKER_HPP_
+#define MOBILINKD__TNC__INPUT_TRACKER_HPP_
+
+#include "LevelMeter.hpp"
+
+#include <cstdint>
+
+namespace mobilinkd { namespace tnc {
+
+/**
+ * Follow the input DC level and range while receiving, from the level
+ * windows of the input monitor (about 100ms each).
+ *
+ * The DC level is a running average of the window averages with a time
+ * constant of 2^GROUND_SHIFT windows (6.4s).  Packets come and go much
+ * faster than that, so it follows only drift.  A gain change moves the
+ * DC level at once, so the average starts again from the first window
+ * after the input settles.
+ *
+ * Each input gain step is 6dB.  The gain should step down when the
+ * input clips in CLIP_WINDOWS windows in a row.  It should step up only
+ * when the largest Vpp seen with a carrier over RAISE_WINDOWS windows
+ * (one minute) would still be below half of full scale when doubled.
+ * The 2x margin between the two keeps the gain from hunting.  Windows
+ * without a carrier do not count toward stepping up, so that the gain
+ * is not raised to suit the noise of an idle channel.
+ *
+ * Clipping usually happens during a packet, when the gain must not be
+ * changed.  A recommendation is kept until the caller applies it with
+ * set_gain() (or dismisses it by setting the same gain).
+ *
+ * @tparam VREF is the full scale ADC sample.
+ */
+template <uint16_t VREF>
+struct InputTracker
+{
+    static constexpr uint32_t GROUND_SHIFT = 6;
+    static constexpr uint32_t CLIP_WINDOWS = 3;
+    static constexpr uint32_t RAISE_WINDOWS = 600;
+    static constexpr uint32_t SETTLE_WINDOWS = 2;   ///< After a gain change.
+    static constexpr int MAX_GAIN = 4;
+
+    uint32_t ground_{0};        ///< Average DC level << GROUND_SHIFT.
+    uint32_t clipped_{0};       ///< Clipped windows in a row.
+    uint32_t windows_{0};       ///< Windows toward stepping up.
+    uint16_t max_pp_{0};        ///< Largest Vpp with a carrier.
+    uint32_t settle_{0};        ///< Windows left to skip.
+    bool reseed_{false};        ///< Start the DC level from the next window.
+    int gain_{0};
+    int step_{0};               ///< The recommended step.
+
+    /**
+     * @param ground is the current virtual ground.
+     * @param gain is the current input gain setting.
+     */
+    void reset(uint16_t ground, int gain)
+    {
+        ground_ = uint32_t(ground) << GROUND_SHIFT;
+        gain_ = gain;
+        restart();
+        settle_ = 0;
+        reseed_ = false;
+    }
+
+    uint16_t ground() const
+    {
+        return (ground_ + (1 << (GROUND_SHIFT - 1))) >> GROUND_SHIFT;
+    }
+
+    int gain() const { return gain_; }
+
+    /**
+     * Add one level window.
+     *
+     * @param levels are the levels for the window.
+     * @param carrier is true if a carrier was detected.
+     * @return the recommended input gain step: -1, 0 or 1.
+     */
+    int operator()(const LevelMeter& levels, bool carrier)
+    {
+        if (settle_) {
+            --settle_;
+            return step_;
+        }
+
+        if (reseed_) {
+            ground_ = uint32_t(levels.avg()) << GROUND_SHIFT;
+            reseed_ = false;
+        } else {
+            ground_ = ground_ - (ground_ >> GROUND_SHIFT) + levels.avg();
+        }
+
+        if (levels.min() == 0 or levels.max() >= VREF) {
+            if (++clipped_ >= CLIP_WINDOWS and gain_ > 0) step_ = -1;
+        } else {
+            clipped_ = 0;
+        }
+
+        if (carrier and levels.pp() > max_pp_) max_pp_ = levels.pp();
+        if (++windows_ < RAISE_WINDOWS) return step_;
+
+        if (step_ == 0 and max_pp_ != 0 and uint32_t(max_pp_) * 2 < VREF / 2
+                and gain_ < MAX_GAIN) {
+            step_ = 1;
+        }
+        windows_ = 0;
+        max_pp_ = 0;
+        return step_;
+    }
+
+    /**
+     * Record a gain change and skip the windows while the input settles.
+     * If the gain is not the same, the DC level is taken from the first
+     * window after that.
+     */
+    void set_gain(int gain)
+    {
+        if (gain != gain_) reseed_ = true;
+        gain_ = gain;
+        restart();
+        settle_ = SETTLE_WINDOWS;
+    }
+
+private:
+
+    void restart()
+    {
+        step_ = 0;
+        clipped_ = 0;
+        windows_ = 0;
+        max_pp_ = 0;
+    }
+};
+
+}} // mobilinkd::tnc
+
+#endif // MOBILINKD__TNC__INPUT_TRACKER_HPP_
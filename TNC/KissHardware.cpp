@@ -6,6 +6,7 @@
 #include "AudioInput.hpp"
 #include "AudioLevel.hpp"
 #include "IOEventTask.h"
+#include "Modem.hpp"
 #include <ModulatorTask.hpp>
 
 #include <memory>
@@ -189,6 +190,7 @@ void Hardware::handle_request(hdlc::IoFrame* frame) {
     case hardware::POLL_INPUT_LEVEL:
         DEBUG("POLL_INPUT_VOLUME");
         reply8(hardware::POLL_INPUT_LEVEL, 0);
+        if (audio::pollLiveInput(hardware::POLL_INPUT_LEVEL)) break;
         osMessagePut(audioInputQueueHandle, audio::POLL_AMPLIFIED_INPUT_LEVEL,
             osWaitForever);
         osMessagePut(audioInputQueueHandle, audio::DEMODULATOR,
@@ -255,6 +257,7 @@ void Hardware::handle_request(hdlc::IoFrame* frame) {
 
     case hardware::POLL_INPUT_TWIST:
       DEBUG("POLL_INPUT_TWIST");
+      if (audio::pollLiveInput(hardware::POLL_INPUT_TWIST)) break;
       osMessagePut(audioInputQueueHandle, audio::POLL_TWIST_LEVEL,
           osWaitForever);
       osMessagePut(audioInputQueueHandle, audio::DEMODULATOR,
@@ -411,6 +414,43 @@ void Hardware::handle_request(hdlc::IoFrame* frame) {
             options & KISS_OPTION_PTT_SIMPLEX ? 0 : 1);
         break;
 
+    case hardware::SET_FIX_BITS:
+        DEBUG("SET_FIX_BITS");
+        options &= ~(KISS_OPTION_FIX_BITS | KISS_OPTION_FIX_BIT_PAIRS);
+        if (*it == 1) {
+          options |= KISS_OPTION_FIX_BITS;
+        } else if (*it > 1) {
+          options |= KISS_OPTION_FIX_BITS | KISS_OPTION_FIX_BIT_PAIRS;
+        }
+        update_crc();
+        osMessagePut(audioInputQueueHandle, audio::DEMODULATOR,
+            osWaitForever);
+        [[fallthrough]];
+    case hardware::GET_FIX_BITS:
+        DEBUG("GET_FIX_BITS");
+        reply8(hardware::GET_FIX_BITS,
+            options & KISS_OPTION_FIX_BIT_PAIRS ? 2 :
+            options & KISS_OPTION_FIX_BITS ? 1 : 0);
+        break;
+    case hardware::GET_DEMOD_STATS:
+        {
+            DEBUG("GET_DEMOD_STATS");
+            auto& stats = audio::demodulatorStats();
+            auto& duplicates = audio::duplicateFilter();
+            const uint32_t values[hardware::DEMOD_STATS_COUNT] = {
+                stats.blocks, stats.frames, stats.unique, stats.dropped,
+                duplicates.hits(), duplicates.misses()};
+            uint8_t data[sizeof(values)];
+            for (size_t i = 0; i != hardware::DEMOD_STATS_COUNT; i++) {
+                data[i * 4] = (values[i] >> 24) & 0xFF;
+                data[i * 4 + 1] = (values[i] >> 16) & 0xFF;
+                data[i * 4 + 2] = (values[i] >> 8) & 0xFF;
+                data[i * 4 + 3] = values[i] & 0xFF;
+            }
+            reply(hardware::GET_DEMOD_STATS, data, sizeof(data));
+        }
+        break;
+
     case hardware::SET_USB_POWER_OFF:
         DEBUG("SET_USB_POWER_OFF");
         if (*it) {
@@ -521,15 +561,30 @@ void Hardware::handle_ext_request(hdlc::IoFrame* frame) {
     switch (ext_command) {
     case hardware::EXT_GET_MODEM_TYPE:
         DEBUG("EXT_GET_MODEM_TYPE");
-        ext_reply(hardware::EXT_GET_MODEM_TYPE, 1);
+        ext_reply(hardware::EXT_GET_MODEM_TYPE, modem_type);
         break;
     case hardware::EXT_SET_MODEM_TYPE:
         DEBUG("EXT_SET_MODEM_TYPE");
+        if (not findModem(*it)) {
+            ERROR("Unsupported modem type %d", int(*it));
+            ext_reply(hardware::EXT_GET_MODEM_TYPE, modem_type);
+            break;
+        }
+        modem_type = *it;
+        update_crc();
+        updateModulator();
+        osMessagePut(audioInputQueueHandle, audio::DEMODULATOR,
+            osWaitForever);
         ext_reply(hardware::EXT_OK, hardware::EXT_SET_MODEM_TYPE);
         break;
     case hardware::EXT_GET_MODEM_TYPES:
-        DEBUG("EXT_GET_MODEM_TYPES");
-        ext_reply(hardware::EXT_GET_MODEM_TYPES, 1);
+        {
+            DEBUG("EXT_GET_MODEM_TYPES");
+            uint8_t types[MODEM_COUNT];
+            for (size_t i = 0; i != MODEM_COUNT; i++) types[i] = modems[i].type;
+            reply_ext(hardware::EXTENDED_CMD, hardware::EXT_GET_MODEM_TYPES,
+                types, MODEM_COUNT);
+        }
         break;
     }
 }
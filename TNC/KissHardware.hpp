@@ -125,6 +125,19 @@ constexpr const uint8_t GET_BT_POWER_OFF = 78;
 
 constexpr const uint8_t SET_PTT_CHANNEL = 79; // Which PTT line to use (currently 0 or 1,
 constexpr const uint8_t GET_PTT_CHANNEL = 80; // multiplex or simplex)
+constexpr const uint8_t SET_FIX_BITS = 81; // Fix RX frames with bad CRC (0 = off,
+constexpr const uint8_t GET_FIX_BITS = 82; // 1 = single bits, 2 = adjacent pairs too)
+constexpr const uint8_t GET_DEMOD_STATS = 83; // Receive counters since the demodulator
+                                              // started, 6 x uint32_t (see below)
+
+/**
+ * The GET_DEMOD_STATS reply is six big-endian uint32_t counters, reset
+ * each time the demodulator is started: ADC blocks processed, frames
+ * decoded by all demodulator branches, frames forwarded, frames dropped
+ * on a full queue, then the duplicate filter's duplicates suppressed and
+ * new frames seen.
+ */
+constexpr const size_t DEMOD_STATS_COUNT = 6;
 
 constexpr const uint8_t GET_MIN_OUTPUT_TWIST = 119;  ///< int8_t (may be negative).
 constexpr const uint8_t GET_MAX_OUTPUT_TWIST = 120;  ///< int8_t (may be negative).
@@ -172,6 +185,8 @@ constexpr const uint8_t MODEM_TYPE_MFSK16 = 6;
 #define KISS_OPTION_VIN_POWER_ON    0x04  // Power on when plugged into USB
 #define KISS_OPTION_VIN_POWER_OFF   0x08  // Power off when unplugged from USB
 #define KISS_OPTION_PTT_SIMPLEX     0x10  // Simplex PTT (the default)
+#define KISS_OPTION_FIX_BITS        0x20  // Fix single bit errors in RX frames
+#define KISS_OPTION_FIX_BIT_PAIRS   0x40  // ... and adjacent bit pairs
 
 const char TOCALL[] = "APML30"; // Update for every feature change.
 
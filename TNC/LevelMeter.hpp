@@ -0,0 +1,148 @@
+// Copyright 2019 Rob Riggs <rob@mobilinkd.com>
+// All rights reserved.
+
+#ifndef MOBILINKD__TNC__LEVEL_METER_HPP_
+#define MOBILINKD__TNC__LEVEL_METER_HPP_
+
+#include "arm_math.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace mobilinkd { namespace tnc {
+
+/**
+ * Input level statistics over any number of ADC blocks: minimum, maximum,
+ * sum and sum of squares, updated in one pass over each block.
+ *
+ * The samples are read two at a time as a 32-bit word.  USUB16/SEL keep
+ * a running minimum and maximum for each half of the word (min16x2() and
+ * max16x2()), and SMLALD adds the squares of both halves in one
+ * instruction.  The two halves are combined when the results are read.
+ *
+ * The samples must be right justified ADC samples of no more than 15
+ * bits, so that they are also valid signed 16-bit values.
+ */
+struct LevelMeter
+{
+    uint32_t min_;          ///< Two packed running minimums.
+    uint32_t max_;          ///< Two packed running maximums.
+    uint64_t sum_;
+    uint64_t sum_sq_;
+    uint32_t count_;
+
+    LevelMeter() { reset(); }
+
+    /*
+     * SEL picks each half by the GE flags that USUB16 sets.  The flags are
+     * not an operand of the intrinsics, so nothing stops the compiler from
+     * moving other flag-setting instructions between them; on the target
+     * both are in one asm statement.
+     */
+
+    /// The unsigned minimum of each 16-bit half of a and b.
+    static uint32_t min16x2(uint32_t a, uint32_t b)
+    {
+#ifdef __ARM_FEATURE_SIMD32
+        uint32_t result;
+        __ASM ("usub16 %0, %1, %2\n\t"
+               "sel %0, %2, %1"
+            : "=&r" (result) : "r" (a), "r" (b) : "cc");
+        return result;
+#else
+        __USUB16(a, b);                     // GE set where a >= b.
+        return __SEL(b, a);
+#endif
+    }
+
+    /// The unsigned maximum of each 16-bit half of a and b.
+    static uint32_t max16x2(uint32_t a, uint32_t b)
+    {
+#ifdef __ARM_FEATURE_SIMD32
+        uint32_t result;
+        __ASM ("usub16 %0, %1, %2\n\t"
+               "sel %0, %1, %2"
+            : "=&r" (result) : "r" (a), "r" (b) : "cc");
+        return result;
+#else
+        __USUB16(a, b);                     // GE set where a >= b.
+        return __SEL(a, b);
+#endif
+    }
+
+    void reset()
+    {
+        min_ = 0xFFFFFFFF;
+        max_ = 0;
+        sum_ = 0;
+        sum_sq_ = 0;
+        count_ = 0;
+    }
+
+    /**
+     * Add a block of samples.
+     *
+     * @param samples must be 4-byte aligned.
+     * @param n is the number of samples; it must be even and less than
+     *  65536.
+     */
+    void operator()(const uint16_t* samples, size_t n)
+    {
+        auto words = reinterpret_cast<const uint32_t*>(samples);
+        uint32_t vmin = min_;
+        uint32_t vmax = max_;
+        uint32_t sum = 0;
+        uint64_t sum_sq = sum_sq_;
+
+        for (size_t i = 0; i != n / 2; ++i) {
+            uint32_t w = words[i];
+            vmin = min16x2(w, vmin);
+            vmax = max16x2(w, vmax);
+            sum = __SMLAD(w, 0x00010001, sum);
+            sum_sq = __SMLALD(w, w, sum_sq);
+        }
+
+        min_ = vmin;
+        max_ = vmax;
+        sum_ += sum;
+        sum_sq_ = sum_sq;
+        count_ += n;
+    }
+
+    uint32_t count() const { return count_; }
+
+    uint16_t min() const
+    {
+        return std::min(uint16_t(min_), uint16_t(min_ >> 16));
+    }
+
+    uint16_t max() const
+    {
+        return std::max(uint16_t(max_), uint16_t(max_ >> 16));
+    }
+
+    /// Peak to peak.
+    uint16_t pp() const { return count_ ? max() - min() : 0; }
+
+    /// Average (the DC level).
+    uint16_t avg() const { return count_ ? sum_ / count_ : 0; }
+
+    /**
+     * RMS of the signal around its average (the AC level).  This is the
+     * difference of two large numbers and needs double precision; it is
+     * only done when the result is read.
+     */
+    uint16_t rms() const
+    {
+        if (!count_) return 0;
+        double mean = double(sum_) / count_;
+        double variance = double(sum_sq_) / count_ - mean * mean;
+        return variance > 0.0 ? uint16_t(sqrt(variance)) : 0;
+    }
+};
+
+}} // mobilinkd::tnc
+
+#endif // MOBILINKD__TNC__LEVEL_METER_HPP_
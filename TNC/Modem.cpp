@@ -0,0 +1,55 @@
+// Copyright 2019 Rob Riggs <rob@mobilinkd.com>
+// All rights reserved.
+
+#include "Modem.hpp"
+#include "AudioInput.hpp"
+#include "Fsk9600Demodulator.hpp"
+#include "KissHardware.hpp"
+#include "ModulatorTask.hpp"
+
+namespace mobilinkd { namespace tnc {
+
+namespace {
+
+Modulator& afsk1200Modulator() { return getAFSKModulator(); }
+Modulator& afsk300Modulator() { return getAfsk300Modulator(); }
+Modulator& fsk9600Modulator() { return getFsk9600Modulator(); }
+
+} // namespace
+
+const std::array<Modem, MODEM_COUNT> modems = {{
+    {
+        kiss::hardware::MODEM_TYPE_1200, "AFSK 1200",
+        audio::SAMPLE_RATE, audio::ADC_BUFFER_SIZE,
+        AFSKModulator::SAMPLE_RATE, AFSKModulator::BIT_LEN,
+        audio::afsk1200DemodulatorTask, afsk1200Modulator
+    },
+    {
+        kiss::hardware::MODEM_TYPE_300, "AFSK 300",
+        audio::SAMPLE_RATE, audio::ADC_BUFFER_SIZE,
+        Afsk300Modulator::SAMPLE_RATE, Afsk300Modulator::BIT_LEN,
+        audio::afsk300DemodulatorTask, afsk300Modulator
+    },
+    {
+        kiss::hardware::MODEM_TYPE_9600, "G3RUH 9600",
+        fsk9600::SAMPLE_RATE, audio::ADC_BUFFER_SIZE,
+        Fsk9600Modulator::SAMPLE_RATE, Fsk9600Modulator::FILL_LEN,
+        audio::fsk9600DemodulatorTask, fsk9600Modulator
+    },
+}};
+
+const Modem* findModem(uint8_t type)
+{
+    for (const auto& modem : modems) {
+        if (modem.type == type) return &modem;
+    }
+    return nullptr;
+}
+
+const Modem& currentModem()
+{
+    auto modem = findModem(kiss::settings().modem_type);
+    return modem ? *modem : modems.front();
+}
+
+}} // mobilinkd::tnc
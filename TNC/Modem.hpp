@@ -0,0 +1,55 @@
+// Copyright 2019 Rob Riggs <rob@mobilinkd.com>
+// All rights reserved.
+
+#ifndef MOBILINKD__TNC__MODEM_HPP_
+#define MOBILINKD__TNC__MODEM_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace mobilinkd { namespace tnc {
+
+struct Modulator;
+
+/**
+ * A modem that can be selected with EXT_SET_MODEM_TYPE.  Each modem
+ * provides the demodulator task and the modulator, and declares the ADC
+ * and DAC sample rates and block sizes that they run at.  The timers that
+ * trigger the ADC (TIM6) and the DAC (TIM7) are set from these rates when
+ * the demodulator and the modulator start.
+ *
+ * The modems are listed in modems[], in Modem.cpp.  To add a modem, add
+ * an entry there and bump MODEM_COUNT.
+ */
+struct Modem
+{
+    /// Runs the demodulator until the audio input task is given a new state.
+    typedef void (*demodulator_type)(const Modem& modem);
+    /// Returns the modulator instance.
+    typedef Modulator& (*modulator_type)();
+
+    uint8_t type;                   ///< kiss::hardware::MODEM_TYPE_*
+    const char* name;
+    uint32_t adc_sample_rate;
+    size_t adc_block_size;          ///< Samples per demodulator call.
+    uint32_t dac_sample_rate;
+    size_t dac_block_size;          ///< Samples per modulator fill.
+    demodulator_type demodulate;
+    modulator_type modulator;
+};
+
+constexpr size_t MODEM_COUNT = 3;
+
+/// The supported modems.  The first one is the default.
+extern const std::array<Modem, MODEM_COUNT> modems;
+
+/// The modem for a MODEM_TYPE_* value, or nullptr if it is not supported.
+const Modem* findModem(uint8_t type);
+
+/// The modem for the configured modem type, or the default modem.
+const Modem& currentModem();
+
+}} // mobilinkd::tnc
+
+#endif // MOBILINKD__TNC__MODEM_HPP_
@@ -0,0 +1,58 @@
+// Copyright 2019 Rob Riggs <rob@mobilinkd.com>
+// All rights reserved.
+
+#ifndef MOBILINKD__TNC__MODULATOR_HPP_
+#define MOBILINKD__TNC__MODULATOR_HPP_
+
+#include "PTT.hpp"
+
+#include "stm32l4xx_hal.h"
+
+#include <cstdint>
+
+extern TIM_HandleTypeDef htim7;
+
+namespace mobilinkd { namespace tnc {
+
+/**
+ * The interface between the HDLC encoder and the DAC.  The encoder sends
+ * NRZI encoded bits with send(); the modulator queues them and the DAC DMA
+ * callbacks call fill_first()/fill_last() with each queued value to fill
+ * the half of the DAC buffer that is not being sent.
+ */
+struct Modulator
+{
+    virtual ~Modulator() {}
+
+    virtual void set_ptt(PTT* ptt) = 0;
+    virtual void set_volume(uint16_t v) = 0;
+    virtual void set_twist(uint8_t) {}
+
+    /// Bits per second; used for the TX delay.
+    virtual uint32_t bit_rate() const = 0;
+
+    virtual void send(bool bit) = 0;
+
+    /// Queue any bits held back by send(), at the end of a transmission.
+    virtual void flush() {}
+
+    virtual void fill_first(uint32_t value) = 0;
+    virtual void fill_last(uint32_t value) = 0;
+    virtual void empty() = 0;
+    virtual void abort() = 0;
+
+    /// True when nothing is being sent: the DAC is stopped and PTT is off.
+    virtual bool idle() const = 0;
+
+protected:
+
+    /// Set the DAC sample rate.  TIM7 triggers the DAC.
+    static void set_sample_rate(uint32_t sample_rate)
+    {
+        __HAL_TIM_SET_AUTORELOAD(&htim7, SystemCoreClock / sample_rate - 1);
+    }
+};
+
+}} // mobilinkd::tnc
+
+#endif // MOBILINKD__TNC__MODULATOR_HPP_
@@ -3,14 +3,23 @@
 
 #include "ModulatorTask.hpp"
 #include "KissHardware.hpp"
+#include "Modem.hpp"
+#include "AudioLevel.hpp"
 #include "main.h"
 
 mobilinkd::tnc::SimplexPTT simplexPtt;
 mobilinkd::tnc::MultiplexPTT multiplexPtt;
 
-mobilinkd::tnc::AFSKModulator* modulator;
+mobilinkd::tnc::Modulator* modulator;
 mobilinkd::tnc::hdlc::Encoder* encoder;
 
+using mobilinkd::tnc::hdlc::Encoder;
+
+// Wake the encoder if it is waiting for the modulator to stop.
+static void signalIdle() {
+    if (modulator->idle()) osSignalSet(modulatorTaskHandle, Encoder::IDLE_SIGNAL);
+}
+
 // DMA Conversion half complete.
 extern "C" void HAL_DAC_ConvHalfCpltCallbackCh1(DAC_HandleTypeDef*) {
     osEvent evt = osMessageGet(dacOutputQueueHandle, 0);
@@ -18,6 +27,7 @@ extern "C" void HAL_DAC_ConvHalfCpltCallbackCh1(DAC_HandleTypeDef*) {
         modulator->fill_first(evt.value.v);
     } else {
         modulator->empty();
+        signalIdle();
     }
 }
 
@@ -27,18 +37,34 @@ extern "C" void HAL_DAC_ConvCpltCallbackCh1(DAC_HandleTypeDef*) {
         modulator->fill_last(evt.value.v);
     } else {
         modulator->empty();
+        signalIdle();
     }
 }
 
 extern "C" void HAL_DAC_DMAUnderrunCallbackCh1(DAC_HandleTypeDef*) {
     modulator->abort();
+    signalIdle();
 }
 
-mobilinkd::tnc::AFSKModulator& getModulator() {
+mobilinkd::tnc::AFSKModulator& getAFSKModulator() {
     static mobilinkd::tnc::AFSKModulator instance(dacOutputQueueHandle, &simplexPtt);
     return instance;
 }
 
+mobilinkd::tnc::Afsk300Modulator& getAfsk300Modulator() {
+    static mobilinkd::tnc::Afsk300Modulator instance(dacOutputQueueHandle, &simplexPtt);
+    return instance;
+}
+
+mobilinkd::tnc::Fsk9600Modulator& getFsk9600Modulator() {
+    static mobilinkd::tnc::Fsk9600Modulator instance(dacOutputQueueHandle, &simplexPtt);
+    return instance;
+}
+
+mobilinkd::tnc::Modulator& getModulator() {
+    return mobilinkd::tnc::currentModem().modulator();
+}
+
 mobilinkd::tnc::hdlc::Encoder& getEncoder() {
     static mobilinkd::tnc::hdlc::Encoder instance(hdlcOutputQueueHandle, &getModulator());
     return instance;
@@ -66,6 +92,40 @@ void updatePtt()
         modulator->set_ptt(&multiplexPtt);
 }
 
+/**
+ * Switch to the modulator for the configured modem type.  The encoder
+ * calls this on the modulator task, between frames, with the previous
+ * modulator idle.
+ */
+static mobilinkd::tnc::Modulator* switchModulator()
+{
+    using namespace mobilinkd::tnc::kiss;
+
+    auto& current = getModulator();
+    if (&current == modulator) return modulator;
+
+    modulator->abort();
+    modulator = &current;
+
+    updatePtt();
+    modulator->set_twist(settings().tx_twist);
+    mobilinkd::tnc::audio::setAudioOutputLevel();
+    return modulator;
+}
+
+bool sendFrame(mobilinkd::tnc::hdlc::IoFrame* frame)
+{
+    if (osMessagePut(hdlcOutputQueueHandle, reinterpret_cast<uint32_t>(frame),
+        osWaitForever) != osOK) return false;
+    osSignalSet(modulatorTaskHandle, Encoder::FRAME_SIGNAL);
+    return true;
+}
+
+void updateModulator()
+{
+    osSignalSet(modulatorTaskHandle, Encoder::UPDATE_SIGNAL);
+}
+
 void startModulatorTask(void const*) {
 
     using namespace mobilinkd::tnc::kiss;
@@ -75,6 +135,7 @@ void startModulatorTask(void const*) {
 
     modulator = &(getModulator());
     encoder = &(getEncoder());
+    encoder->on_update(switchModulator);
 
     updatePtt();
 
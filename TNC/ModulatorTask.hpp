@@ -7,6 +7,7 @@
 
 #include "HDLCEncoder.hpp"
 #include "AFSKModulator.hpp"
+#include "Fsk9600Modulator.hpp"
 #include "PTT.hpp"
 #include "cmsis_os.h"
 
@@ -17,10 +18,17 @@ extern "C" {
 extern mobilinkd::tnc::SimplexPTT simplexPtt;
 extern mobilinkd::tnc::MultiplexPTT multiplexPtt;
 
-extern mobilinkd::tnc::AFSKModulator* modulator;
+extern osThreadId modulatorTaskHandle;
+
+extern mobilinkd::tnc::Modulator* modulator;
 extern mobilinkd::tnc::hdlc::Encoder* encoder;
 
-mobilinkd::tnc::AFSKModulator& getModulator();
+mobilinkd::tnc::AFSKModulator& getAFSKModulator();
+mobilinkd::tnc::Afsk300Modulator& getAfsk300Modulator();
+mobilinkd::tnc::Fsk9600Modulator& getFsk9600Modulator();
+
+/// The modulator for the configured modem type (see currentModem()).
+mobilinkd::tnc::Modulator& getModulator();
 mobilinkd::tnc::hdlc::Encoder& getEncoder();
 
 void startModulatorTask(void const * argument);
@@ -31,6 +39,20 @@ void setPtt(PTT ptt);
 
 void updatePtt(void);
 
+/**
+ * Queue the frame to be sent by the modulator task, which then owns it.
+ * Returns false if it could not be queued; the caller still owns it.
+ */
+bool sendFrame(mobilinkd::tnc::hdlc::IoFrame* frame);
+
+/**
+ * Switch to the modulator for the configured modem type and apply the
+ * PTT, twist and volume settings to it.  The switch is made by the
+ * modulator task once the frames already queued have been sent and the
+ * modulator is idle.
+ */
+void updateModulator(void);
+
 #ifdef __cplusplus
 }
 #endif
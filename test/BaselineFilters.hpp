@@ -0,0 +1,156 @@
+// Copyright 2019 Rob Riggs <rob@mobilinkd.com>
+// All rights reserved.
+
+#ifndef MOBILINKD__TEST__BASELINE_FILTERS_HPP_
+#define MOBILINKD__TEST__BASELINE_FILTERS_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace mobilinkd { namespace tnc { namespace test { namespace baseline {
+
+/*
+ * The filter tables as they were pasted from scipy before FilterDesign.hpp
+ * computed them, at an audio::SAMPLE_RATE of 26400Hz (48000Hz for the
+ * 9600 baud matched filter).  filter_design compares the designed tables
+ * with these.
+ */
+
+// AudioInput.hpp bpf_coeffs.
+constexpr std::array<int16_t, 132> bpf_coeffs = {
+    4,     0,    -5,   -10,   -13,   -12,    -9,    -4,    -2,    -4,   -12,   -26,
+  -41,   -52,   -51,   -35,    -3,    39,    83,   117,   131,   118,    83,    36,
+   -6,   -32,   -30,    -3,    36,    67,    66,    19,   -74,  -199,  -323,  -408,
+ -421,  -344,  -187,    17,   218,   364,   417,   369,   247,   106,    14,    26,
+  166,   407,   676,   865,   866,   605,    68,  -675, -1484, -2171, -2547, -2471,
+-1895,  -882,   394,  1692,  2747,  3337,  3337,  2747,  1692,   394,  -882, -1895,
+-2471, -2547, -2171, -1484,  -675,    68,   605,   866,   865,   676,   407,   166,
+   26,    14,   106,   247,   369,   417,   364,   218,    17,  -187,  -344,  -421,
+ -408,  -323,  -199,   -74,    19,    66,    67,    36,    -3,   -30,   -32,    -6,
+   36,    83,   118,   131,   117,    83,    39,    -3,   -35,   -51,   -52,   -41,
+  -26,   -12,    -4,    -2,    -4,    -9,   -12,   -13,   -10,    -5,     0,     4,
+};
+
+// AfskDemodulator.hpp lpf_coeffs.
+constexpr std::array<int16_t, 96> lpf_coeffs = {
+    0,     1,     3,     5,     8,    11,    14,    17,    19,    20,    18,    14,
+    7,    -2,   -16,   -33,   -53,   -76,  -101,  -126,  -151,  -174,  -194,  -208,
+ -215,  -212,  -199,  -173,  -133,   -79,   -10,    74,   173,   287,   413,   549,
+  693,   842,   993,  1142,  1287,  1423,  1547,  1656,  1747,  1817,  1865,  1889,
+ 1889,  1865,  1817,  1747,  1656,  1547,  1423,  1287,  1142,   993,   842,   693,
+  549,   413,   287,   173,    74,   -10,   -79,  -133,  -173,  -199,  -212,  -215,
+ -208,  -194,  -174,  -151,  -126,  -101,   -76,   -53,   -33,   -16,    -2,     7,
+   14,    18,    20,    19,    17,    14,    11,     8,     5,     3,     1,     0,
+};
+
+// Fsk9600Demodulator.hpp matched_filter_coeffs.
+constexpr std::array<int16_t, 32> matched_filter_coeffs = {
+  -21,   -60,   -84,   -52,    78,   273,   387,   221,
+ -301,  -974, -1305,  -731,  1017,  3642,  6306,  7987,
+ 7987,  6306,  3642,  1017,  -731, -1305,  -974,  -301,
+  221,   387,   273,    78,   -52,   -84,   -60,   -21,
+};
+
+// DigitalPLL.hpp loop_coeffs and loop_coeffs_q15.
+constexpr std::array<float, 7> loop_coeffs = {
+    3.196252e-02, 1.204223e-01, 2.176819e-01, 2.598666e-01,
+    2.176819e-01, 1.204223e-01, 3.196252e-02
+};
+
+constexpr std::array<int16_t, 7> loop_coeffs_q15 = {
+    1047, 3946, 7133, 8515, 7133, 3946, 1047
+};
+
+// DigitalPLL.hpp lock filter: bessel(4, [80.0/(1200/2)], 'lowpass').
+constexpr std::array<double, 5> lock_b = {
+    1.077063e-03, 4.308253e-03, 6.462379e-03, 4.308253e-03, 1.077063e-03
+};
+
+constexpr std::array<double, 5> lock_a = {
+    1.000000e+00, -2.774567e+00, 2.962960e+00, -1.437990e+00, 2.668296e-01
+};
+
+// FilterCoefficients.hpp emphasis filters, dB_6 to dB12 as in AfskFilters.
+constexpr std::array<float, 9> emphasis[] = {
+    {{ // dB_6
+        0.104477241089, 0.130913242609, 0.151854419973, 0.165293215366, 0.169923761926,
+        0.165293215366, 0.151854419973, 0.130913242609, 0.104477241089
+    }},
+    {{ // dB_5
+        0.0782137588209, 0.118736939542, 0.153156300897, 0.176223458893, 0.184339083696,
+        0.176223458893, 0.153156300897, 0.118736939542, 0.0782137588209
+    }},
+    {{ // dB_4
+        0.0498539382844, 0.103801174967, 0.153695746099, 0.188874162863, 0.201549955573,
+        0.188874162863, 0.153695746099, 0.103801174967, 0.0498539382844
+    }},
+    {{ // dB_3
+        0.0221215152936, 0.0832006412609, 0.151534395598, 0.205025020719, 0.225236854257,
+        0.205025020719, 0.151534395598, 0.0832006412609, 0.0221215152936
+    }},
+    {{ // dB_2
+        0.00299520319909, 0.0482175156295, 0.137632853632, 0.228067265055, 0.266174324969,
+        0.228067265055, 0.137632853632, 0.0482175156295, 0.00299520319909
+    }},
+    {{ // dB_1
+        -0.0107931468169, -0.0322211933056, -0.0506402474814, -0.0630689498437, 1.1522865023,
+        -0.0630689498437, -0.0506402474814, -0.0322211933056, -0.0107931468169
+    }},
+    {{ // dB0
+        1.0, 1.0, 1.0, 1.0, 1.0,
+        1.0, 1.0, 1.0, 1.0
+    }},
+    {{ // dB1
+        -0.0107931468169, -0.0322211933056, -0.0506402474814, -0.0630689498437, 1.1522865023,
+        -0.0630689498437, -0.0506402474814, -0.0322211933056, -0.0107931468169
+    }},
+    {{ // dB2
+        -0.0185923370593, -0.0601029235689, -0.0996864670836, -0.128090353439, 1.30017105427,
+        -0.128090353439, -0.0996864670836, -0.0601029235689, -0.0185923370593
+    }},
+    {{ // dB3
+        -0.0231416146776, -0.0833375337803, -0.147937602401, -0.197411259519, 1.46066084756,
+        -0.197411259519, -0.147937602401, -0.0833375337803, -0.0231416146776
+    }},
+    {{ // dB4
+        -0.0209448226653, -0.130107651829, -0.299004731072, -0.45336946386, 2.0629448761,
+        -0.45336946386, -0.299004731072, -0.130107651829, -0.0209448226653
+    }},
+    {{ // dB5
+        -0.0209448226653, -0.130107651829, -0.299004731072, -0.45336946386, 2.0629448761,
+        -0.45336946386, -0.299004731072, -0.130107651829, -0.0209448226653
+    }},
+    {{ // dB6
+        -0.0209448226653, -0.130107651829, -0.299004731072, -0.45336946386, 2.0629448761,
+        -0.45336946386, -0.299004731072, -0.130107651829, -0.0209448226653
+    }},
+    {{ // dB7
+        -0.0159546975608, -0.137623905223, -0.349491872081, -0.553149017309, 2.28934729422,
+        -0.553149017309, -0.349491872081, -0.137623905223, -0.0159546975608
+    }},
+    {{ // dB8
+        -0.0096785005294, -0.141786249744, -0.399423790874, -0.658608816643, 2.52741445003,
+        -0.658608816643, -0.399423790874, -0.141786249744, -0.0096785005294
+    }},
+    {{ // dB9
+        -0.00232554104135, -0.142858725752, -0.449053780255, -0.770264863826, 2.77651146344,
+        -0.770264863826, -0.449053780255, -0.142858725752, -0.00232554104135
+    }},
+    {{ // dB10
+        0.00564557245371, -0.141643920093, -0.498513944796, -0.887264289827, 3.03792032485,
+        -0.887264289827, -0.498513944796, -0.141643920093, 0.00564557245371
+    }},
+    {{ // dB11
+        0.0138943225784, -0.137800909104, -0.544488104185, -1.00269495093, 3.29019584315,
+        -1.00269495093, -0.544488104185, -0.137800909104, 0.0138943225784
+    }},
+    {{ // dB12
+        0.0223997567081, -0.132588208904, -0.590869965255, -1.12325491747, 3.55525416434,
+        -1.12325491747, -0.590869965255, -0.132588208904, 0.0223997567081
+    }},
+};
+
+}}}} // mobilinkd::tnc::test::baseline
+
+#endif // MOBILINKD__TEST__BASELINE_FILTERS_HPP_
@@ -0,0 +1,167 @@
+// Copyright 2019 Rob Riggs <rob@mobilinkd.com>
+// All rights reserved.
+
+#ifndef MOBILINKD__TEST__TEST_SIGNAL_HPP_
+#define MOBILINKD__TEST__TEST_SIGNAL_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace mobilinkd { namespace tnc { namespace test {
+
+/*
+ * Test signals for the host tests: AX.25 frames as HDLC bit streams, and
+ * those bits as AFSK audio with twist and noise, scaled to ADC samples.
+ */
+
+typedef std::vector<uint8_t> bytes_type;
+typedef std::vector<bool> bits_type;
+typedef std::vector<float> audio_type;
+typedef std::vector<uint16_t> samples_type;
+
+/// The AX.25 FCS (CRC-16/X.25) of the frame contents.
+inline uint16_t fcs(const bytes_type& data)
+{
+    uint16_t crc = 0xFFFF;
+    for (auto byte : data) {
+        crc ^= byte;
+        for (int i = 0; i != 8; ++i) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0x8408 : crc >> 1;
+        }
+    }
+    return crc ^ 0xFFFF;
+}
+
+/// An APRS position report with a different SSID, number and length for each k.
+inline bytes_type aprsFrame(int k)
+{
+    bytes_type result;
+
+    auto address = [&result](const char* call, int ssid, bool last) {
+        std::string padded(call);
+        padded.resize(6, ' ');
+        for (char c : padded) result.push_back(uint8_t(c) << 1);
+        result.push_back(0x60 | (ssid << 1) | (last ? 1 : 0));
+    };
+
+    address("APRS", 0, false);
+    address("N0CALL", k % 16, true);
+    result.push_back(0x03);
+    result.push_back(0xF0);
+
+    char info[48];
+    snprintf(info, sizeof(info), "!4903.50N/07201.75W-Test %03d ", k % 1000);
+    result.insert(result.end(), info, info + strlen(info));
+    result.insert(result.end(), (k * 37) % 61, 'x');
+    return result;
+}
+
+inline void appendByte(bits_type& bits, uint8_t byte)
+{
+    for (int i = 0; i != 8; ++i) bits.push_back((byte >> i) & 1);
+}
+
+inline void appendFlags(bits_type& bits, size_t count)
+{
+    for (size_t i = 0; i != count; ++i) appendByte(bits, 0x7E);
+}
+
+/// The frame and its FCS, LSB first and bit stuffed, without flags.
+inline void appendFrame(bits_type& bits, const bytes_type& frame)
+{
+    auto data = frame;
+    auto crc = fcs(frame);
+    data.push_back(crc & 0xFF);
+    data.push_back(crc >> 8);
+
+    int ones = 0;
+    for (auto byte : data) {
+        for (int i = 0; i != 8; ++i) {
+            bool bit = (byte >> i) & 1;
+            bits.push_back(bit);
+            ones = bit ? ones + 1 : 0;
+            if (ones == 5) {
+                bits.push_back(false);
+                ones = 0;
+            }
+        }
+    }
+}
+
+/**
+ * Continuous-phase AFSK.  The HDLC bits are NRZI encoded: a zero changes
+ * the tone.  Mark is sent at unit amplitude and space at the twist.
+ */
+struct AfskModulator
+{
+    double sample_rate;
+    double baud;
+    double mark;
+    double space;
+    double phase{0.0};
+    double clock{0.0};
+    bool tone{true};    ///< Mark.
+
+    AfskModulator(double sample_rate, double baud, double mark, double space)
+    : sample_rate(sample_rate), baud(baud), mark(mark), space(space)
+    {}
+
+    void operator()(const bits_type& bits, double twist_db, audio_type& out)
+    {
+        const double space_gain = std::pow(10.0, twist_db / 20.0);
+        const double samples_per_bit = sample_rate / baud;
+        for (bool bit : bits) {
+            if (not bit) tone = not tone;
+            clock += samples_per_bit;
+            for (; clock >= 1.0; clock -= 1.0) {
+                phase += 2.0 * M_PI * (tone ? mark : space) / sample_rate;
+                if (phase > 2.0 * M_PI) phase -= 2.0 * M_PI;
+                out.push_back(std::sin(phase) * (tone ? 1.0 : space_gain));
+            }
+        }
+    }
+};
+
+/// Add white gaussian noise at snr_db below the RMS of the signal.
+template <typename Random>
+void addNoise(audio_type::iterator first, audio_type::iterator last,
+    double snr_db, Random& random)
+{
+    double power = 0.0;
+    for (auto it = first; it != last; ++it) power += *it * *it;
+    power /= std::max<std::ptrdiff_t>(1, last - first);
+
+    std::normal_distribution<double> noise(0.0,
+        std::sqrt(power) * std::pow(10.0, -snr_db / 20.0));
+    for (auto it = first; it != last; ++it) *it += noise(random);
+}
+
+/**
+ * Scale the audio to peak at +/-amplitude ADC counts around vgnd, and pad
+ * it with vgnd to a whole number of blocks.
+ */
+inline samples_type toAdcSamples(const audio_type& audio, uint16_t vgnd,
+    double amplitude, size_t block_size)
+{
+    double peak = 1e-9;
+    for (auto x : audio) peak = std::max(peak, double(std::fabs(x)));
+
+    samples_type result;
+    result.reserve(audio.size() + block_size);
+    for (auto x : audio) {
+        long sample = std::lround(x / peak * amplitude) + vgnd;
+        result.push_back(uint16_t(std::min(std::max(sample, 0L), 2L * vgnd - 1)));
+    }
+    result.resize((result.size() + block_size - 1) / block_size * block_size, vgnd);
+    return result;
+}
+
+}}} // mobilinkd::tnc::test
+
+#endif // MOBILINKD__TEST__TEST_SIGNAL_HPP_
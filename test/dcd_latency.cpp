@@ -0,0 +1,199 @@
+// Copyright 2019 Rob Riggs <rob@mobilinkd.com>
+// All rights reserved.
+
+/*
+ * Measure how long the energy carrier detector (EnergyDcd) and the
+ * demodulator lock take to detect a carrier, for 1200 and 300 baud AFSK.
+ * The signal is a minute of noise followed by bursts of flags and random
+ * data at several SNRs, with noise between them, processed in ADC blocks
+ * as in the demodulator tasks.  The delay is from the start of a burst to
+ * the end of the first block in which the detector is on, in bits.
+ *
+ *   dcd_latency [1200 | 300]
+ *
+ * Fails if the energy detector is not faster than the lock at each SNR,
+ * misses bursts above 4dB SNR, or is on in more than 1% of noise blocks.
+ */
+
+#include "TestSignal.hpp"
+
+#include "Afsk300Demodulator.hpp"
+#include "AfskDemodulator.hpp"
+#include "EnergyDcd.hpp"
+#include "FilterCoefficients.hpp"
+#include "HdlcFrame.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace mobilinkd::tnc;
+
+namespace {
+
+using audio::ADC_BUFFER_SIZE;
+using audio::SAMPLE_RATE;
+
+const int SNR[] = {20, 12, 6, 2, 0, -3, -6};
+constexpr size_t BURSTS = 20;           // At each SNR.
+
+struct Burst
+{
+    size_t start;       ///< First sample.
+    size_t length;
+    int snr;
+    long energy{-1};    ///< Delay in samples, or -1 if not detected.
+    long lock{-1};
+};
+
+/**
+ * Noise, then the bursts.  The noise level is constant; the bursts are
+ * scaled to their SNR against it.
+ */
+test::samples_type makeSignal(int baud, double mark, double space,
+    std::vector<Burst>& bursts, size_t& noise_end)
+{
+    std::mt19937 random(7);
+    std::uniform_real_distribution<double> gap(0.3, 0.8);
+    std::uniform_int_distribution<int> coin(0, 1);
+    std::normal_distribution<double> noise(0.0, 1.0);
+
+    test::audio_type signal(SAMPLE_RATE * 60, 0.0f);
+    noise_end = signal.size();
+
+    test::AfskModulator modulator(SAMPLE_RATE, baud, mark, space);
+    for (size_t k = 0; k != BURSTS * std::size(SNR); ++k) {
+        signal.resize(signal.size() + size_t(SAMPLE_RATE * gap(random)), 0.0f);
+
+        // 0.2s of flags, then 0.3s of random data.
+        test::bits_type bits;
+        test::appendFlags(bits, baud / 40);
+        while (bits.size() < size_t(baud / 2)) bits.push_back(coin(random));
+
+        Burst burst{signal.size(), 0, SNR[k % std::size(SNR)]};
+        modulator(bits, 0.0, signal);
+        burst.length = signal.size() - burst.start;
+
+        // The noise is unit variance; a sine of amplitude a has power a^2/2.
+        double amplitude = std::sqrt(2.0) * std::pow(10.0, burst.snr / 20.0);
+        for (size_t i = burst.start; i != signal.size(); ++i) signal[i] *= amplitude;
+        bursts.push_back(burst);
+    }
+
+    for (auto& x : signal) x += noise(random);
+    return test::toAdcSamples(signal, audio::virtual_ground, 3000, ADC_BUFFER_SIZE);
+}
+
+double median(std::vector<double> v)
+{
+    if (v.empty()) return -1.0;
+    std::sort(v.begin(), v.end());
+    return v[v.size() / 2];
+}
+
+template <typename Demodulator, typename EnergyDetector>
+bool measure(int baud, double mark, double space, Demodulator& demod,
+    EnergyDetector& energy_dcd)
+{
+    std::vector<Burst> bursts;
+    size_t noise_end;
+    auto samples = makeSignal(baud, mark, space, bursts, noise_end);
+
+    Q15SymmetricFirFilter<ADC_BUFFER_SIZE, audio::FILTER_TAP_NUM> audio_filter;
+    audio_filter.init(audio::bpf_coeffs.data());
+
+    q15_t normalized[ADC_BUFFER_SIZE];
+    size_t noise_blocks = 0, noise_energy = 0, noise_lock = 0;
+    size_t current = 0;
+
+    for (size_t block = 0; block != samples.size() / ADC_BUFFER_SIZE; ++block) {
+        arm_offset_q15((q15_t*) &samples[block * ADC_BUFFER_SIZE],
+            0 - audio::virtual_ground, normalized, ADC_BUFFER_SIZE);
+        bool energy = energy_dcd(normalized);
+        for (auto frame : demod(audio_filter(normalized), ADC_BUFFER_SIZE)) {
+            if (frame) hdlc::release(frame);
+        }
+        bool lock = demod.locked();
+
+        size_t end = (block + 1) * ADC_BUFFER_SIZE;
+        if (end <= noise_end) {
+            ++noise_blocks;
+            noise_energy += energy;
+            noise_lock += lock;
+            continue;
+        }
+
+        while (current != bursts.size()
+            and end > bursts[current].start + bursts[current].length) ++current;
+        if (current == bursts.size() or end <= bursts[current].start) continue;
+
+        auto& burst = bursts[current];
+        long delay = long(end - burst.start);
+        if (energy and burst.energy < 0) burst.energy = delay;
+        if (lock and burst.lock < 0) burst.lock = delay;
+    }
+
+    bool ok = true;
+    double false_rate = 100.0 * noise_energy / noise_blocks;
+    printf("%d baud: noise detected as a carrier in %.2f%% of blocks "
+        "(lock %.2f%%)\n", baud, false_rate, 100.0 * noise_lock / noise_blocks);
+    if (false_rate > 1.0) ok = false;
+
+    const double samples_per_bit = double(SAMPLE_RATE) / baud;
+    for (int snr : SNR) {
+        std::vector<double> energy, lock;
+        size_t energy_missed = 0, lock_missed = 0;
+        for (auto& burst : bursts) {
+            if (burst.snr != snr) continue;
+            if (burst.energy < 0) ++energy_missed;
+            else energy.push_back(burst.energy / samples_per_bit);
+            if (burst.lock < 0) ++lock_missed;
+            else lock.push_back(burst.lock / samples_per_bit);
+        }
+
+        double energy_median = median(energy), lock_median = median(lock);
+        printf("  %2ddB SNR: energy %5.1f bits (%zu missed), "
+            "lock %5.1f bits (%zu missed)\n", snr, energy_median,
+            energy_missed, lock_median, lock_missed);
+
+        if (snr > 4 and energy_missed != 0) ok = false;
+        if (energy_median < 0
+            or (lock_median >= 0 and energy_median >= lock_median)) ok = false;
+    }
+
+    return ok;
+}
+
+bool measure1200()
+{
+    static afsk1200::FusedDemodulator<3> demod(SAMPLE_RATE);
+    for (size_t i = 0; i != demod.size(); ++i) {
+        demod.init(i, *filter::fir::AfskFixedFilters[6]);
+    }
+    EnergyDcd<ADC_BUFFER_SIZE, 88> energy_dcd(1200, 2200, 600, 3300);
+    return measure(1200, 1200, 2200, demod, energy_dcd);
+}
+
+bool measure300()
+{
+    static afsk300::Demodulator demod(afsk300::MARK_FREQ, afsk300::SPACE_FREQ);
+    demod.init();
+    EnergyDcd<ADC_BUFFER_SIZE, 264> energy_dcd(afsk300::MARK_FREQ,
+        afsk300::SPACE_FREQ, 1000, 2400);
+    return measure(300, afsk300::MARK_FREQ, afsk300::SPACE_FREQ, demod, energy_dcd);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    int baud = argc > 1 ? atoi(argv[1]) : 0;
+
+    bool ok = true;
+    if (baud == 0 or baud == 1200) ok = measure1200() and ok;
+    if (baud == 0 or baud == 300) ok = measure300() and ok;
+
+    printf(ok ? "OK\n" : "FAIL\n");
+    return ok ? 0 : 1;
+}
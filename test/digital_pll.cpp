@@ -0,0 +1,198 @@
+// Copyright 2019 Rob Riggs <rob@mobilinkd.com>
+// All rights reserved.
+
+/*
+ * Compare FixedDigitalPLL with the float BaseDigitalPLL it replaced, on
+ * the same sliced discriminator output, and time them.
+ *
+ *   digital_pll
+ *
+ * The input is the sign of a demodulated signal at each modem's sample
+ * and symbol rate: random symbols with a clock error, jittered edges and
+ * glitches, then noise alone so that the PLLs lose lock.  Each sample
+ * decision of one PLL must be within one ADC sample of one by the other,
+ * and each lock change within LOCK_SLACK symbols, but for a few where the
+ * rounding sends them different ways.
+ */
+
+#include "DigitalPLL.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace mobilinkd::tnc;
+
+namespace {
+
+typedef std::chrono::steady_clock clock_type;
+typedef std::vector<bool> bits_type;
+
+/// The fraction of sample and lock decisions that may differ.
+constexpr double SAMPLE_TOLERANCE = 1e-3;
+constexpr double LOCK_TOLERANCE = 0.05;
+
+/// How far a lock change may move, in symbols.
+constexpr size_t LOCK_SLACK = 10;
+
+struct Rates
+{
+    const char* name;
+    uint32_t sample_rate;
+    uint32_t symbol_rate;
+};
+
+const Rates RATES[] = {
+    {"afsk1200", 26400, 1200},
+    {"afsk1200/2", 13200, 1200},
+    {"afsk300", 26400, 300},
+    {"fsk9600", 48000, 9600},
+};
+
+/**
+ * Sliced discriminator output.  Each burst is data at a clock error of up
+ * to 0.5%, with edges moved by up to 10% of a symbol and a one sample
+ * glitch in 2% of the symbols, followed by noise with runs of up to a
+ * symbol.
+ */
+bits_type discriminator(const Rates& rates, std::mt19937& random)
+{
+    const double sps = double(rates.sample_rate) / rates.symbol_rate;
+
+    std::uniform_real_distribution<double> error(-0.005, 0.005);
+    std::normal_distribution<double> jitter(0.0, 0.05 * sps);
+
+    bits_type bits;
+    for (int burst = 0; burst != 20; ++burst) {
+        double step = 1.0 + error(random);
+        double edge = 0.0;
+        bool level = false;
+        for (int symbol = 0; symbol != 1000; ++symbol) {
+            double next = (symbol + 1) * sps / step
+                + std::max(-0.1 * sps, std::min(0.1 * sps, jitter(random)));
+            size_t start = bits.size();
+            for (; edge < next; edge += 1.0) bits.push_back(level);
+            if (random() % 50 == 0 and bits.size() != start) {
+                size_t glitch = start + random() % (bits.size() - start);
+                bits[glitch] = not level;
+            }
+            if (random() & 1) level = not level;
+        }
+
+        for (size_t i = 0; i < 300 * sps;) {
+            size_t run = 1 + random() % size_t(sps);
+            bool noise = random() & 1;
+            for (size_t j = 0; j != run; ++j, ++i) bits.push_back(noise);
+        }
+    }
+    return bits;
+}
+
+/// Where the PLL samples, and where it gains and loses lock.
+struct Decisions
+{
+    std::vector<size_t> samples;
+    std::vector<size_t> locks;
+};
+
+template <typename PLL>
+Decisions run(const Rates& rates, const bits_type& bits)
+{
+    PLL pll(rates.sample_rate, rates.symbol_rate);
+    Decisions result;
+    bool locked = false;
+    for (size_t i = 0; i != bits.size(); ++i) {
+        auto r = pll(bits[i]);
+        if (r.sample) result.samples.push_back(i);
+        if (r.locked != locked) result.locks.push_back(i);
+        locked = r.locked;
+    }
+    return result;
+}
+
+/// The time per sample, in ns: the best of several runs of a few passes.
+template <typename PLL>
+double time(const Rates& rates, const bits_type& bits)
+{
+    const int RUNS = 5;
+    const int PASSES = 10;
+
+    volatile uint32_t sink = 0;
+    auto best = clock_type::duration::max();
+    for (int run = 0; run != RUNS; ++run) {
+        auto start = clock_type::now();
+        for (int pass = 0; pass != PASSES; ++pass) {
+            PLL pll(rates.sample_rate, rates.symbol_rate);
+            uint32_t count = 0;
+            for (bool bit : bits) {
+                auto r = pll(bit);
+                count += r.sample + r.locked;
+            }
+            sink = sink + count;
+        }
+        best = std::min(best, clock_type::now() - start);
+    }
+    return std::chrono::duration<double, std::nano>(best).count()
+        / (double(PASSES) * bits.size());
+}
+
+/// The decisions in a that are not within slack samples of one in b.
+size_t unmatched(const std::vector<size_t>& a, const std::vector<size_t>& b,
+    size_t slack)
+{
+    size_t result = 0;
+    auto it = b.begin();
+    for (auto i : a) {
+        while (it != b.end() and *it + slack < i) ++it;
+        if (it == b.end() or *it > i + slack) ++result;
+    }
+    return result;
+}
+
+bool compare(const Rates& rates, std::mt19937& random)
+{
+    typedef BaseDigitalPLL<float> FloatPLL;
+
+    const size_t sps = rates.sample_rate / rates.symbol_rate;
+
+    auto bits = discriminator(rates, random);
+    auto floating = run<FloatPLL>(rates, bits);
+    auto fixed = run<FixedDigitalPLL>(rates, bits);
+
+    // A sample may move by one ADC sample.  The lock filter is slow, so a
+    // small difference in the jitter near a threshold can move a lock
+    // change by several symbols.
+    size_t sample_diff = unmatched(floating.samples, fixed.samples, 1)
+        + unmatched(fixed.samples, floating.samples, 1);
+    size_t lock_diff = unmatched(floating.locks, fixed.locks, LOCK_SLACK * sps)
+        + unmatched(fixed.locks, floating.locks, LOCK_SLACK * sps);
+
+    double float_ns = time<FloatPLL>(rates, bits);
+    double fixed_ns = time<FixedDigitalPLL>(rates, bits);
+
+    printf("  %-10s %6zu symbols sampled, %zu differ; %3zu lock changes, %zu differ;"
+        " float %4.1fns, fixed %4.1fns/sample\n", rates.name,
+        floating.samples.size(), sample_diff, floating.locks.size(), lock_diff,
+        float_ns, fixed_ns);
+
+    // Both must lock on the data and lose lock in the noise.
+    return floating.locks.size() >= 2
+        and sample_diff <= SAMPLE_TOLERANCE * floating.samples.size()
+        and lock_diff <= LOCK_TOLERANCE * floating.locks.size();
+}
+
+} // namespace
+
+int main()
+{
+    std::mt19937 random(1);
+    bool ok = true;
+    for (auto& rates : RATES) {
+        ok = compare(rates, random) and ok;
+    }
+
+    printf(ok ? "OK\n" : "FAIL\n");
+    return ok ? 0 : 1;
+}
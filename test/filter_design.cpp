@@ -0,0 +1,146 @@
+// Copyright 2019 Rob Riggs <rob@mobilinkd.com>
+// All rights reserved.
+
+/*
+ * Compare the filter tables computed by FilterDesign.hpp with the scipy
+ * tables they replaced (BaselineFilters.hpp).  The Q15 and Q12 tables must
+ * be identical; the float tables must agree to the precision they were
+ * pasted with.
+ *
+ *   filter_design
+ *
+ * The tables depend on audio::SAMPLE_RATE, so the comparison is only
+ * made at 26400Hz.
+ */
+
+#include "BaselineFilters.hpp"
+
+#include "AfskDemodulator.hpp"
+#include "AudioInput.hpp"
+#include "DigitalPLL.hpp"
+#include "FilterCoefficients.hpp"
+#include "Fsk9600Demodulator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+using namespace mobilinkd::tnc;
+
+namespace {
+
+bool ok = true;
+
+template <typename Designed, typename Baseline>
+void compareExact(const char* name, const Designed& designed,
+    const Baseline& baseline)
+{
+    size_t size = std::size(designed);
+    size_t mismatched = 0;
+    if (size != std::size(baseline)) {
+        printf("  %-24s %zu taps, expected %zu\n", name, size, std::size(baseline));
+        ok = false;
+        return;
+    }
+
+    for (size_t i = 0; i != size; ++i) {
+        if (int32_t(designed[i]) == int32_t(baseline[i])) continue;
+        if (mismatched++ == 0) {
+            printf("  %-24s tap %zu is %ld, expected %ld\n", name, i,
+                long(designed[i]), long(baseline[i]));
+        }
+    }
+
+    if (mismatched) ok = false;
+    else printf("  %-24s %zu taps identical\n", name, size);
+}
+
+template <typename Designed, typename Baseline>
+void compareNear(const char* name, const Designed& designed,
+    const Baseline& baseline, double tolerance)
+{
+    double worst = 0.0;
+    for (size_t i = 0; i != std::size(baseline); ++i) {
+        worst = std::max(worst, std::fabs(double(designed[i]) - double(baseline[i])));
+    }
+
+    printf("  %-24s max difference %.2g\n", name, worst);
+    if (worst > tolerance) ok = false;
+}
+
+/// The transfer function of the sections, b and a, for comparison with bessel(..., 'ba').
+template <typename T, size_t N>
+void sosToBa(const BiquadCoefficients<T, N>& sos, std::array<double, 2 * N + 1>& b,
+    std::array<double, 2 * N + 1>& a)
+{
+    b = {1.0};
+    a = {1.0};
+    for (size_t k = 0; k != N; ++k) {
+        std::array<double, 2 * N + 1> nb{}, na{};
+        for (size_t i = 0; i != 2 * k + 1; ++i) {
+            for (size_t j = 0; j != 3; ++j) {
+                nb[i + j] += b[i] * sos[k][j];
+                na[i + j] += a[i] * (j == 0 ? 1.0 : sos[k][j + 2]);
+            }
+        }
+        b = nb;
+        a = na;
+    }
+}
+
+void compareTables()
+{
+    namespace baseline = test::baseline;
+
+    compareExact("bpf_coeffs", audio::bpf_coeffs, baseline::bpf_coeffs);
+    compareExact("lpf_coeffs", afsk1200::lpf_coeffs, baseline::lpf_coeffs);
+    compareExact("matched_filter_coeffs", fsk9600::matched_filter_coeffs,
+        baseline::matched_filter_coeffs);
+
+    // Pasted with 7 significant digits.
+    compareNear("loop_coeffs", pll::loop_coeffs, baseline::loop_coeffs, 5e-7);
+    compareExact("loop_coeffs_q15", pll::loop_coeffs_q15, baseline::loop_coeffs_q15);
+
+    // The old sections were made from b and a pasted with 7 significant
+    // digits; a[2] is 2.962960.
+    std::array<double, 5> b, a;
+    sosToBa(pll::lock_design, b, a);
+    compareNear("lock_sos (b)", b, baseline::lock_b, 5e-9);
+    compareNear("lock_sos (a)", a, baseline::lock_a, 1e-6);
+
+    // Pasted with 12 significant digits, and stored as float.
+    const char* names[] = {"dB_6", "dB_5", "dB_4", "dB_3", "dB_2", "dB_1",
+        "dB0", "dB1", "dB2", "dB3", "dB4", "dB5", "dB6", "dB7", "dB8", "dB9",
+        "dB10", "dB11", "dB12"};
+    static_assert(std::size(names) == std::size(filter::fir::AfskFilters));
+    static_assert(std::size(names) == std::size(baseline::emphasis));
+
+    for (size_t i = 0; i != std::size(names); ++i) {
+        std::string name = names[i];
+        compareNear(name.c_str(), filter::fir::AfskFilters[i]->taps,
+            baseline::emphasis[i], 1e-6);
+
+        TFirCoefficients<9> old{};
+        std::copy(baseline::emphasis[i].begin(), baseline::emphasis[i].end(), old.taps);
+        auto quantized = quantize<filter::fir::AFSK_FILTER_FRACTION_BITS>(old);
+        compareExact((name + "_q").c_str(), filter::fir::AfskFixedFilters[i]->taps,
+            quantized.taps);
+    }
+}
+
+} // namespace
+
+int main()
+{
+    if (audio::SAMPLE_RATE != 26400) {
+        printf("SAMPLE_RATE is %lu; the tables are for 26400Hz\n",
+            (unsigned long) audio::SAMPLE_RATE);
+        return 0;
+    }
+
+    compareTables();
+
+    printf(ok ? "OK\n" : "FAIL\n");
+    return ok ? 0 : 1;
+}
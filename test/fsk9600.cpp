@@ -0,0 +1,203 @@
+// Copyright 2019 Rob Riggs <rob@mobilinkd.com>
+// All rights reserved.
+
+/*
+ * Loop the G3RUH 9600 baud modulator back into the demodulator.  Frames
+ * are NRZI encoded and sent to Fsk9600Modulator the way the HDLC encoder
+ * sends them, the DAC buffer is played out the way the DAC callbacks
+ * fill it, and the samples are given to fsk9600::Demodulator as ADC
+ * blocks, with noise.  This covers the scrambler and the descrambler.
+ *
+ *   fsk9600
+ *
+ * Each transmission must send every bit given to the modulator (none are
+ * left over for the next one), and every frame must be decoded.
+ */
+
+#include "TestSignal.hpp"
+
+#include "Fsk9600Demodulator.hpp"
+#include "Fsk9600Modulator.hpp"
+#include "HdlcFrame.hpp"
+#include "NRZI.hpp"
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace mobilinkd::tnc;
+
+namespace {
+
+using audio::ADC_BUFFER_SIZE;
+
+struct NullPTT : PTT
+{
+    void on() {}
+    void off() {}
+};
+
+/// The modulator and what the HDLC encoder keeps for it.
+struct Transmitter
+{
+    HostQueue queue;
+    NullPTT ptt;
+    Fsk9600Modulator modulator{&queue, &ptt};
+    mobilinkd::libafsk::NRZI nrzi;
+    size_t bits{0};     ///< Bits given to the modulator.
+
+    void send(const test::bits_type& hdlc)
+    {
+        for (bool bit : hdlc) modulator.send(nrzi.encode(bit));
+        bits += hdlc.size();
+    }
+
+    /**
+     * Send the frames as one transmission, as the encoder does: the TX
+     * delay, the frames sharing flags, an IDLE byte and a flush().
+     */
+    void transmit(const std::vector<test::bytes_type>& frames)
+    {
+        bits = 0;
+        test::bits_type hdlc;
+        for (int i = 0; i != 24; ++i) test::appendByte(hdlc, 0x00);
+        test::appendFlags(hdlc, 1);
+        for (auto& frame : frames) {
+            test::appendFrame(hdlc, frame);
+            test::appendFlags(hdlc, 1);
+        }
+        test::appendByte(hdlc, 0x00);
+        send(hdlc);
+        modulator.flush();
+    }
+
+    /**
+     * Play the DAC buffer until the modulator stops, calling fill_first(),
+     * fill_last() and empty() as the DAC callbacks do.
+     *
+     * @return the number of words sent.
+     */
+    size_t play(test::audio_type& out)
+    {
+        const size_t FILL_LEN = Fsk9600Modulator::FILL_LEN;
+
+        size_t words = 2;   // Filled by send() before starting the DMA.
+        for (size_t half = 0; not modulator.idle(); half ^= 1) {
+            const uint16_t* samples = modulator.buffer_ + half * FILL_LEN;
+            for (size_t i = 0; i != FILL_LEN; ++i) {
+                out.push_back((int(samples[i]) - 2048) / 2048.0f);
+            }
+
+            osEvent evt = osMessageGet(&queue, 0);
+            if (evt.status != osEventMessage) {
+                modulator.empty();
+            } else if (half == 0) {
+                modulator.fill_first(evt.value.v);
+                ++words;
+            } else {
+                modulator.fill_last(evt.value.v);
+                ++words;
+            }
+        }
+        return words;
+    }
+};
+
+struct Receiver
+{
+    fsk9600::Demodulator demod;
+    std::vector<test::bytes_type> frames;
+
+    void operator()(const test::samples_type& samples)
+    {
+        q15_t normalized[ADC_BUFFER_SIZE];
+        for (size_t block = 0; block != samples.size() / ADC_BUFFER_SIZE; ++block) {
+            arm_offset_q15((q15_t*) &samples[block * ADC_BUFFER_SIZE],
+                0 - audio::virtual_ground, normalized, ADC_BUFFER_SIZE);
+            for (auto frame : demod(normalized, ADC_BUFFER_SIZE)) {
+                if (not frame) continue;
+                // Less the FCS.
+                test::bytes_type data(frame->begin(), frame->end());
+                data.resize(data.size() - 2);
+                frames.push_back(data);
+                hdlc::release(frame);
+            }
+        }
+    }
+};
+
+/**
+ * Send TRANSMISSIONS transmissions of 1 to 3 frames at the SNR, with
+ * noise between them, and decode them.
+ */
+bool loopback(double snr_db, std::mt19937& random)
+{
+    const size_t TRANSMISSIONS = 40;
+
+    Transmitter transmitter;
+    static Receiver receiver;
+    receiver.frames.clear();
+
+    std::vector<test::bytes_type> sent;
+    test::audio_type signal;
+    std::normal_distribution<float> noise(0.0, 0.02);
+    bool ok = true;
+
+    for (size_t k = 0; k != TRANSMISSIONS; ++k) {
+        for (size_t i = 0; i != fsk9600::SAMPLE_RATE / 20; ++i) {
+            signal.push_back(noise(random));
+        }
+
+        std::vector<test::bytes_type> frames;
+        for (size_t i = 0; i != k % 3 + 1; ++i) {
+            frames.push_back(test::aprsFrame(k * 3 + i));
+        }
+        sent.insert(sent.end(), frames.begin(), frames.end());
+
+        transmitter.transmit(frames);
+        auto start = signal.size();
+        size_t words = transmitter.play(signal);
+        test::addNoise(signal.begin() + start, signal.end(), snr_db, random);
+
+        // Every bit and at least one more, so the last is shaped.
+        size_t bits = transmitter.bits;
+        if (words * 8 <= bits or words * 8 > bits + 8) {
+            printf("  transmission %zu: %zu bits sent in %zu words\n",
+                k, bits, words);
+            ok = false;
+        }
+    }
+
+    for (size_t i = 0; i != fsk9600::SAMPLE_RATE / 20; ++i) {
+        signal.push_back(noise(random));
+    }
+    receiver(test::toAdcSamples(signal, audio::virtual_ground, 1500,
+        ADC_BUFFER_SIZE));
+
+    size_t decoded = 0;
+    for (auto& frame : sent) {
+        for (auto& received : receiver.frames) {
+            if (received == frame) {
+                ++decoded;
+                break;
+            }
+        }
+    }
+
+    printf("  %4.1fdB: %zu of %zu frames decoded\n", snr_db, decoded, sent.size());
+    return ok and decoded == sent.size();
+}
+
+} // namespace
+
+int main()
+{
+    std::mt19937 random(1);
+    bool ok = true;
+    for (double snr_db : {30.0, 20.0, 15.0}) {
+        ok = loopback(snr_db, random) and ok;
+    }
+
+    printf(ok ? "OK\n" : "FAIL\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,333 @@
+// Copyright 2019 Rob Riggs <rob@mobilinkd.com>
+// All rights reserved.
+
+/*
+ * Check that NewDecoder gives the same frames a byte at a time
+ * (operator()(uint8_t), as the demodulators use it) as it does one bit at
+ * a time through process() (operator()(bool, bool)).
+ *
+ *   hdlc_decoder
+ *
+ * The bit streams are:
+ *  - frames with flags, bit errors, aborts, noise and long runs of ones;
+ *  - frames at every bit offset from the byte boundary, with data that is
+ *    stuffed at every bit position, and back-to-back frames that share
+ *    a flag or the zero between flags;
+ *  - bits captured from the 1200 baud PLL on AFSK frames in noise;
+ *  - random bits.
+ * Each stream is decoded with and without passall and in each FixBits
+ * mode, and the frames and fix bits statistics must be identical.
+ */
+
+#include "TestSignal.hpp"
+
+#include "AfskDemodulator.hpp"
+#include "FilterCoefficients.hpp"
+#include "HdlcDecoder.hpp"
+#include "HdlcFrame.hpp"
+
+#include <cstdio>
+#include <vector>
+
+using namespace mobilinkd::tnc;
+
+namespace {
+
+using audio::ADC_BUFFER_SIZE;
+using audio::SAMPLE_RATE;
+
+struct Mode
+{
+    const char* name;
+    bool passall;
+    hdlc::FixBits fix_bits;
+};
+
+const Mode MODES[] = {
+    {"passall", true, hdlc::FixBits::NONE},
+    {"none", false, hdlc::FixBits::NONE},
+    {"single", false, hdlc::FixBits::SINGLE},
+    {"adjacent", false, hdlc::FixBits::ADJACENT},
+};
+
+struct Decoded
+{
+    std::vector<test::bytes_type> frames;
+    hdlc::FixBitsStats stats;
+
+    bool operator==(const Decoded& other) const
+    {
+        return frames == other.frames
+            and stats.single == other.stats.single
+            and stats.adjacent == other.stats.adjacent
+            and stats.rejected == other.stats.rejected
+            and stats.failed == other.stats.failed
+            and stats.skipped == other.stats.skipped;
+    }
+};
+
+void collect(hdlc::IoFrame* frame, Decoded& decoded)
+{
+    if (not frame) return;
+    decoded.frames.emplace_back(frame->begin(), frame->end());
+    hdlc::release(frame);
+}
+
+void finish(hdlc::NewDecoder& decoder, Decoded& decoded)
+{
+    decoded.stats = decoder.fix_bits_stats;
+    if (decoder.packet) hdlc::release(decoder.packet);
+    decoder.packet = nullptr;
+}
+
+// The fix bits budget is not limited; the demodulators share it between
+// branches per block, which is not what is being compared here.
+Decoded decodeBits(const test::bits_type& bits, const Mode& mode)
+{
+    Decoded result;
+    hdlc::NewDecoder decoder(mode.passall);
+    decoder.fix_bits_mode = mode.fix_bits;
+    for (bool bit : bits) {
+        decoder.fix_bits_budget = 1 << 30;
+        collect(decoder(bit, true), result);
+    }
+    finish(decoder, result);
+    return result;
+}
+
+Decoded decodeBytes(const test::bits_type& bits, const Mode& mode)
+{
+    Decoded result;
+    hdlc::NewDecoder decoder(mode.passall);
+    decoder.fix_bits_mode = mode.fix_bits;
+    hdlc::BitPacker packer;
+    for (bool bit : bits) {
+        if (not packer(bit)) continue;
+        decoder.fix_bits_budget = 1 << 30;
+        collect(decoder(packer.byte()), result);
+    }
+    finish(decoder, result);
+    return result;
+}
+
+/**
+ * Decode the bits both ways in each mode.  Without passall, at least
+ * minimum_frames must be decoded.
+ */
+bool compare(const char* name, test::bits_type bits, size_t minimum_frames)
+{
+    // The byte path only sees whole bytes.
+    while (bits.size() % 8) bits.push_back(true);
+
+    bool ok = true;
+    printf("  %-10s %8zu bits:", name, bits.size());
+    for (const auto& mode : MODES) {
+        auto by_bit = decodeBits(bits, mode);
+        auto by_byte = decodeBytes(bits, mode);
+        printf(" %s %zu", mode.name, by_bit.frames.size());
+        if (not (by_bit == by_byte)) {
+            printf(" (%zu by byte, MISMATCH)", by_byte.frames.size());
+            ok = false;
+        }
+        if (not mode.passall and by_bit.frames.size() < minimum_frames) {
+            printf(" (expected %zu)", minimum_frames);
+            ok = false;
+        }
+    }
+    printf("\n");
+    return ok;
+}
+
+/// An AX.25 style frame: 14 address bytes, then data with many 0xFF.
+test::bytes_type randomFrame(std::mt19937& random)
+{
+    test::bytes_type result;
+    for (int i = 0; i != 14; ++i) result.push_back(('A' + random() % 26) << 1);
+    result[13] |= 1;
+    size_t size = 15 + random() % 120;
+    while (result.size() < size) {
+        result.push_back(random() % 4 == 0 ? 0xFF : random());
+    }
+    return result;
+}
+
+/**
+ * Frames separated by 1-4 flags, with single and adjacent bit errors,
+ * aborts (7 or more ones), noise, and runs of ones longer than 255 bits
+ * (the width of the ones count).  good counts the frames without errors,
+ * except those after noise: noise ending in five ones makes the zero that
+ * starts a single flag look like a stuffed bit, and the frame is lost.
+ */
+test::bits_type framedBits(std::mt19937& random, size_t& good)
+{
+    test::bits_type bits;
+    bool after_noise = false;
+    for (int k = 0; k != 400; ++k) {
+        int kind = random() % 10;
+        test::appendFlags(bits, 1 + random() % 4);
+        size_t start = bits.size();
+        test::appendFrame(bits, randomFrame(random));
+        size_t size = bits.size() - start;
+
+        if (kind == 0) {
+            size_t p = start + random() % size;
+            bits[p] = not bits[p];
+        } else if (kind == 1) {
+            size_t p = start + random() % (size - 1);
+            bits[p] = not bits[p];
+            bits[p + 1] = not bits[p + 1];
+        } else if (kind == 2) {
+            bits.resize(start + random() % size);
+            bits.insert(bits.end(), 7 + random() % 10, true);
+        } else if (not after_noise) {
+            ++good;
+        }
+
+        test::appendFlags(bits, 1);
+        if (kind == 3) {
+            for (int i = random() % 600; i != 0; --i) bits.push_back(random() & 1);
+        } else if (kind == 4) {
+            bits.insert(bits.end(), random() % 700, true);
+        } else if (kind == 5) {
+            for (int i = random() % 40; i != 0; --i) bits.push_back(random() % 5 != 0);
+        }
+        after_noise = kind == 3 or kind == 5;
+    }
+    return bits;
+}
+
+/**
+ * Frames starting at each bit offset from the byte boundary, whose data
+ * is stuffed at every bit position.  They are sent back-to-back, sharing
+ * the closing flag, or sharing the zero between two flags.
+ */
+test::bits_type stuffedBits(std::mt19937& random, size_t& good)
+{
+    const uint8_t PATTERNS[] = {0xFF, 0x1F, 0xF8, 0x3E, 0x7C, 0xFE, 0x7F, 0xEF};
+
+    test::bits_type bits;
+    for (size_t offset = 0; offset != 8; ++offset) {
+        for (auto pattern : PATTERNS) {
+            for (size_t size = 1; size != 9; ++size) {
+                auto frame = randomFrame(random);
+                frame.resize(14);
+                frame.insert(frame.end(), size * 3, pattern);
+
+                test::appendFlags(bits, 2);
+                bits.insert(bits.end(), offset, false);
+                test::appendFlags(bits, 1);
+                test::appendFrame(bits, frame);
+                test::appendFlags(bits, 1);     // Shared.
+                test::appendFrame(bits, frame);
+
+                // Two flags sharing a zero: 011111101111110.
+                bits.push_back(false);
+                for (int i = 0; i != 2; ++i) {
+                    bits.insert(bits.end(), 6, true);
+                    bits.push_back(false);
+                }
+                test::appendFrame(bits, frame);
+                test::appendFlags(bits, 1);
+                good += 3;
+            }
+        }
+    }
+    return bits;
+}
+
+/**
+ * The bits sampled by the PLL of a 1200 baud demodulator branch from
+ * AFSK frames at SNRs down to 0dB with noise between them.  This follows
+ * DemodulatorBranch::operator() with the levels from FusedDemodulator.
+ */
+test::bits_type capturedBits()
+{
+    const double SNR[] = {20, 12, 6, 3, 0};
+
+    std::mt19937 random(3);
+    std::normal_distribution<float> noise(0.0, 0.05);
+    test::AfskModulator modulator(SAMPLE_RATE, 1200, 1200, 2200);
+    test::audio_type signal;
+    for (int k = 0; k != 60; ++k) {
+        for (size_t i = 0; i != SAMPLE_RATE / 10; ++i) signal.push_back(noise(random));
+        test::bits_type bits;
+        test::appendFlags(bits, 20);
+        test::appendFrame(bits, test::aprsFrame(k));
+        test::appendFlags(bits, 2);
+        auto start = signal.size();
+        modulator(bits, 0.0, signal);
+        test::addNoise(signal.begin() + start, signal.end(), SNR[k % 5], random);
+    }
+    auto samples = test::toAdcSamples(signal, audio::virtual_ground, 3000,
+        ADC_BUFFER_SIZE);
+
+    Q15SymmetricFirFilter<ADC_BUFFER_SIZE, audio::FILTER_TAP_NUM> audio_filter;
+    audio_filter.init(audio::bpf_coeffs.data());
+    static afsk1200::FusedDemodulator<1> demod(SAMPLE_RATE);
+    demod.init(0, *filter::fir::AfskFixedFilters[6]);
+    static afsk1200::DemodulatorBranch branch(SAMPLE_RATE);
+
+    test::bits_type result;
+    q15_t normalized[ADC_BUFFER_SIZE];
+    for (size_t block = 0; block != samples.size() / ADC_BUFFER_SIZE; ++block) {
+        arm_offset_q15((q15_t*) &samples[block * ADC_BUFFER_SIZE],
+            0 - audio::virtual_ground, normalized, ADC_BUFFER_SIZE);
+        for (auto frame : demod(audio_filter(normalized), ADC_BUFFER_SIZE)) {
+            if (frame) hdlc::release(frame);
+        }
+
+        const uint32_t* levels = branch.delay_line_(demod.levels_[0], ADC_BUFFER_SIZE);
+        for (size_t i = 0; i != ADC_BUFFER_SIZE; ++i) {
+            branch.buffer_[i] = (int16_t((levels[i / 32] >> (i % 32)) & 1) << 1) - 1;
+        }
+        auto* fc = branch.lpf_filter_.filter(branch.buffer_);
+        for (size_t i = 0; i != ADC_BUFFER_SIZE / audio::DECIMATION; ++i) {
+            bool bit = fc[i] >= 0;
+            if (branch.pll_(bit).sample) result.push_back(branch.nrzi_.decode(bit));
+        }
+    }
+    return result;
+}
+
+/// Random bits, some biased towards ones so that flags and aborts are common.
+test::bits_type randomBits(std::mt19937& random, size_t count)
+{
+    test::bits_type bits;
+    for (size_t i = 0; i != count; ++i) {
+        bool biased = i / 100000 % 2;
+        bits.push_back(biased and random() % 7 == 0 ? true : random() & 1);
+    }
+    return bits;
+}
+
+} // namespace
+
+int main()
+{
+    bool ok = true;
+
+    for (uint32_t seed = 0; seed != 4; ++seed) {
+        std::mt19937 random(seed);
+        size_t good = 0;
+        auto bits = framedBits(random, good);
+        ok = compare("framed", bits, good) and ok;
+    }
+
+    {
+        std::mt19937 random(10);
+        size_t good = 0;
+        auto bits = stuffedBits(random, good);
+        ok = compare("stuffed", bits, good) and ok;
+    }
+
+    // Most of the frames at 6dB and above are decoded.
+    ok = compare("captured", capturedBits(), 30) and ok;
+
+    for (uint32_t seed = 0; seed != 4; ++seed) {
+        std::mt19937 random(1000 + seed);
+        ok = compare("random", randomBits(random, 1000000), 0) and ok;
+    }
+
+    printf(ok ? "OK\n" : "FAIL\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,16 @@
+// Copyright 2019 Rob Riggs <rob@mobilinkd.com>
+// All rights reserved.
+
+/*
+ * arm_math.h includes "core_cm4.h" from its own directory.  Include the
+ * host core_cm4.h first so that the real one is skipped.  The CMSIS
+ * include directory is a system directory (-isystem) for the host build.
+ */
+
+#ifndef MOBILINKD__TEST__HOST_ARM_MATH_H_
+#define MOBILINKD__TEST__HOST_ARM_MATH_H_
+
+#include "core_cm4.h"
+#include_next <arm_math.h>
+
+#endif // MOBILINKD__TEST__HOST_ARM_MATH_H_
@@ -0,0 +1,66 @@
+// Copyright 2019 Rob Riggs <rob@mobilinkd.com>
+// All rights reserved.
+
+/// Host stand-in for the CMSIS-RTOS API; only what the DSP code uses.
+
+#ifndef MOBILINKD__TEST__HOST_CMSIS_OS_H_
+#define MOBILINKD__TEST__HOST_CMSIS_OS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef void* osMessageQId;
+typedef void* osThreadId;
+typedef void* osMutexId;
+typedef void* osTimerId;
+
+typedef enum {
+    osOK = 0,
+    osEventSignal = 0x08,
+    osEventMessage = 0x10,
+    osEventTimeout = 0x40,
+    osErrorOS = 0xFF
+} osStatus;
+
+typedef struct {
+    osStatus status;
+    union { uint32_t v; void* p; int32_t signals; } value;
+} osEvent;
+
+#define osWaitForever 0xFFFFFFFF
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+osStatus osMessagePut(osMessageQId, uint32_t, uint32_t);
+osEvent osMessageGet(osMessageQId, uint32_t);
+osEvent osMessagePeek(osMessageQId, uint32_t);
+osStatus osThreadYield(void);
+uint32_t osKernelSysTick(void);
+osStatus osDelay(uint32_t);
+osStatus osMutexWait(osMutexId, uint32_t);
+osStatus osMutexRelease(osMutexId);
+int32_t osSignalSet(osThreadId, int32_t);
+osEvent osSignalWait(int32_t, uint32_t);
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifdef __cplusplus
+#include <deque>
+
+/**
+ * A message queue on the host: pass its address as the osMessageQId.
+ * Messages put on a null queue (the firmware's handles) are dropped.
+ */
+typedef std::deque<uint32_t> HostQueue;
+#endif
+
+#define taskENTER_CRITICAL_FROM_ISR() 0
+#define taskEXIT_CRITICAL_FROM_ISR(x) (void)(x)
+#define taskENTER_CRITICAL()
+#define taskEXIT_CRITICAL()
+
+#endif // MOBILINKD__TEST__HOST_CMSIS_OS_H_
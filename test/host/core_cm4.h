@@ -0,0 +1,205 @@
+// Copyright 2019 Rob Riggs <rob@mobilinkd.com>
+// All rights reserved.
+
+/*
+ * Host stand-in for the CMSIS Cortex-M4 core header.  It provides the
+ * SIMD and saturation intrinsics used by the TNC and CMSIS-DSP code as
+ * portable C, and dummy DWT registers for the cycle counter.  The guards
+ * of the real core_cm4.h are defined so that it is skipped when
+ * arm_math.h includes it.
+ */
+
+#ifndef __CORE_CM4_H_GENERIC
+#define __CORE_CM4_H_GENERIC
+#define __CORE_CM4_H_DEPENDANT
+
+#include <stdint.h>
+#include <string.h>
+
+#define __STATIC_INLINE static inline
+#define __INLINE inline
+#define __packed __attribute__((packed))
+#define __ASM asm
+#define __CLZ __builtin_clz
+
+#define HOST_LO(x) ((int16_t)((x) & 0xFFFF))
+#define HOST_HI(x) ((int16_t)(((uint32_t)(x)) >> 16))
+
+static inline uint32_t host_pack(int32_t lo, int32_t hi)
+{
+    return ((uint32_t)(uint16_t)lo) | (((uint32_t)(uint16_t)hi) << 16);
+}
+
+/// The APSR.GE bits set by the SIMD add and subtract, used by __SEL.
+static uint32_t host_ge_flags;
+
+static inline int32_t __SSAT(int32_t v, int bits)
+{
+    int32_t max = (1 << (bits - 1)) - 1, min = -(1 << (bits - 1));
+    return v > max ? max : (v < min ? min : v);
+}
+
+static inline uint32_t __USAT(int32_t v, int bits)
+{
+    int32_t max = (1 << bits) - 1;
+    return v > max ? max : (v < 0 ? 0 : v);
+}
+
+static inline int32_t __QADD(int32_t a, int32_t b)
+{
+    int64_t s = (int64_t)a + b;
+    return s > INT32_MAX ? INT32_MAX : (s < INT32_MIN ? INT32_MIN : (int32_t)s);
+}
+
+static inline int32_t __QSUB(int32_t a, int32_t b)
+{
+    int64_t s = (int64_t)a - b;
+    return s > INT32_MAX ? INT32_MAX : (s < INT32_MIN ? INT32_MIN : (int32_t)s);
+}
+
+static inline int32_t __SMLAD(uint32_t x, uint32_t y, int32_t a)
+{
+    return (int32_t)((uint32_t)a + (uint32_t)(HOST_LO(x) * HOST_LO(y))
+        + (uint32_t)(HOST_HI(x) * HOST_HI(y)));
+}
+
+static inline int32_t __SMLADX(uint32_t x, uint32_t y, int32_t a)
+{
+    return (int32_t)((uint32_t)a + (uint32_t)(HOST_LO(x) * HOST_HI(y))
+        + (uint32_t)(HOST_HI(x) * HOST_LO(y)));
+}
+
+static inline int32_t __SMUAD(uint32_t x, uint32_t y) { return __SMLAD(x, y, 0); }
+static inline int32_t __SMUADX(uint32_t x, uint32_t y) { return __SMLADX(x, y, 0); }
+
+static inline int64_t __SMLALD(uint32_t x, uint32_t y, int64_t a)
+{
+    return a + (int64_t)HOST_LO(x) * HOST_LO(y) + (int64_t)HOST_HI(x) * HOST_HI(y);
+}
+
+static inline int64_t __SMLALDX(uint32_t x, uint32_t y, int64_t a)
+{
+    return a + (int64_t)HOST_LO(x) * HOST_HI(y) + (int64_t)HOST_HI(x) * HOST_LO(y);
+}
+
+static inline int32_t __SMLSD(uint32_t x, uint32_t y, int32_t a)
+{
+    return a + HOST_LO(x) * HOST_LO(y) - HOST_HI(x) * HOST_HI(y);
+}
+
+static inline int32_t __SMUSD(uint32_t x, uint32_t y)
+{
+    return HOST_LO(x) * HOST_LO(y) - HOST_HI(x) * HOST_HI(y);
+}
+
+static inline int32_t __SMUSDX(uint32_t x, uint32_t y)
+{
+    return HOST_LO(x) * HOST_HI(y) - HOST_HI(x) * HOST_LO(y);
+}
+
+static inline uint32_t __QADD16(uint32_t x, uint32_t y)
+{
+    return host_pack(__SSAT(HOST_LO(x) + HOST_LO(y), 16),
+        __SSAT(HOST_HI(x) + HOST_HI(y), 16));
+}
+
+static inline uint32_t __QSUB16(uint32_t x, uint32_t y)
+{
+    return host_pack(__SSAT(HOST_LO(x) - HOST_LO(y), 16),
+        __SSAT(HOST_HI(x) - HOST_HI(y), 16));
+}
+
+static inline uint32_t __SHADD16(uint32_t x, uint32_t y)
+{
+    return host_pack((HOST_LO(x) + HOST_LO(y)) >> 1, (HOST_HI(x) + HOST_HI(y)) >> 1);
+}
+
+static inline uint32_t __QASX(uint32_t x, uint32_t y)
+{
+    return host_pack(__SSAT(HOST_LO(x) - HOST_HI(y), 16),
+        __SSAT(HOST_HI(x) + HOST_LO(y), 16));
+}
+
+static inline uint32_t __QSAX(uint32_t x, uint32_t y)
+{
+    return host_pack(__SSAT(HOST_LO(x) + HOST_HI(y), 16),
+        __SSAT(HOST_HI(x) - HOST_LO(y), 16));
+}
+
+static inline uint32_t __SADD16(uint32_t x, uint32_t y)
+{
+    int32_t lo = HOST_LO(x) + HOST_LO(y), hi = HOST_HI(x) + HOST_HI(y);
+    host_ge_flags = (lo >= 0 ? 3u : 0u) | (hi >= 0 ? 12u : 0u);
+    return host_pack(lo, hi);
+}
+
+static inline uint32_t __SSUB16(uint32_t x, uint32_t y)
+{
+    int32_t lo = HOST_LO(x) - HOST_LO(y), hi = HOST_HI(x) - HOST_HI(y);
+    host_ge_flags = (lo >= 0 ? 3u : 0u) | (hi >= 0 ? 12u : 0u);
+    return host_pack(lo, hi);
+}
+
+static inline uint32_t __USUB16(uint32_t x, uint32_t y)
+{
+    int32_t lo = (int32_t)(x & 0xFFFF) - (int32_t)(y & 0xFFFF);
+    int32_t hi = (int32_t)(x >> 16) - (int32_t)(y >> 16);
+    host_ge_flags = (lo >= 0 ? 3u : 0u) | (hi >= 0 ? 12u : 0u);
+    return host_pack(lo, hi);
+}
+
+static inline uint32_t __SEL(uint32_t a, uint32_t b)
+{
+    uint32_t mask = 0;
+    for (int i = 0; i != 4; ++i) {
+        if (host_ge_flags & (1u << i)) mask |= 0xFFu << (8 * i);
+    }
+    return (a & mask) | (b & ~mask);
+}
+
+static inline uint32_t __SXTB16(uint32_t x)
+{
+    return host_pack((int8_t)(x & 0xFF), (int8_t)((x >> 16) & 0xFF));
+}
+
+static inline uint32_t __ROR(uint32_t x, uint32_t n)
+{
+    n &= 31;
+    return n ? (x >> n) | (x << (32 - n)) : x;
+}
+
+static inline uint32_t __RBIT(uint32_t v)
+{
+    uint32_t result = 0;
+    for (int i = 0; i != 32; ++i) {
+        result = (result << 1) | (v & 1);
+        v >>= 1;
+    }
+    return result;
+}
+
+static inline uint32_t __REV(uint32_t v) { return __builtin_bswap32(v); }
+
+#define __PKHBT(ARG1, ARG2, ARG3) \
+    ((((uint32_t)(ARG1)) & 0x0000FFFFUL) | ((((uint32_t)(ARG2)) << (ARG3)) & 0xFFFF0000UL))
+#define __PKHTB(ARG1, ARG2, ARG3) \
+    ((((uint32_t)(ARG1)) & 0xFFFF0000UL) | ((((uint32_t)(ARG2)) >> (ARG3)) & 0x0000FFFFUL))
+
+typedef struct { volatile uint32_t CTRL; volatile uint32_t CYCCNT; } DWT_Type;
+typedef struct { volatile uint32_t DEMCR; } CoreDebug_Type;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+extern DWT_Type host_dwt;
+extern CoreDebug_Type host_core_debug;
+#ifdef __cplusplus
+}
+#endif
+
+#define DWT (&host_dwt)
+#define CoreDebug (&host_core_debug)
+#define DWT_CTRL_CYCCNTENA_Msk 1u
+#define CoreDebug_DEMCR_TRCENA_Msk (1u << 24)
+
+#endif // __CORE_CM4_H_GENERIC
@@ -0,0 +1,137 @@
+// Copyright 2019 Rob Riggs <rob@mobilinkd.com>
+// All rights reserved.
+
+/*
+ * Definitions that the firmware gets from the HAL, the RTOS and main.c.
+ * The CRC unit is emulated in software with the same configuration as
+ * the firmware uses (CRC-16/CCITT, reflected input and output).
+ */
+
+#include "AudioLevel.hpp"
+
+#include "stm32l4xx_hal.h"
+#include "cmsis_os.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+DWT_Type host_dwt;
+CoreDebug_Type host_core_debug;
+CRC_HandleTypeDef hcrc;
+uint32_t SystemCoreClock = 80000000;
+
+osMessageQId hdlcInputQueueHandle;
+osMessageQId audioInputQueueHandle;
+osMessageQId adcInputQueueHandle;
+osMessageQId ioEventQueueHandle;
+
+TIM_HandleTypeDef htim6;
+TIM_HandleTypeDef htim7;
+ADC_HandleTypeDef hadc1;
+DAC_HandleTypeDef hdac1;
+
+namespace mobilinkd { namespace tnc { namespace audio {
+
+uint16_t virtual_ground = (vref + 1) / 2;
+float i_vgnd = 1.0f / virtual_ground;
+
+}}} // mobilinkd::tnc::audio
+
+namespace {
+
+uint16_t crc_register;
+
+uint16_t reverse16(uint16_t value)
+{
+    uint16_t result = 0;
+    for (int i = 0; i != 16; ++i) {
+        result = (result << 1) | (value & 1);
+        value >>= 1;
+    }
+    return result;
+}
+
+void crc_update(const uint8_t* data, uint32_t size)
+{
+    for (uint32_t i = 0; i != size; ++i) {
+        crc_register ^= data[i];
+        for (int bit = 0; bit != 8; ++bit) {
+            crc_register = (crc_register & 1) ?
+                (crc_register >> 1) ^ 0x8408 : crc_register >> 1;
+        }
+    }
+}
+
+} // namespace
+
+extern "C" {
+
+uint32_t HAL_CRC_Calculate(CRC_HandleTypeDef*, uint32_t* data, uint32_t size)
+{
+    crc_register = 0xFFFF;
+    crc_update(reinterpret_cast<uint8_t*>(data), size);
+    return reverse16(crc_register);
+}
+
+uint32_t HAL_CRC_Accumulate(CRC_HandleTypeDef*, uint32_t* data, uint32_t size)
+{
+    crc_update(reinterpret_cast<uint8_t*>(data), size);
+    return reverse16(crc_register);
+}
+
+void _Error_Handler(const char* file, int line)
+{
+    fprintf(stderr, "error at %s:%d\n", file, line);
+    abort();
+}
+
+osStatus osThreadYield(void)
+{
+    return osOK;
+}
+
+uint32_t host_ticks;
+
+uint32_t osKernelSysTick(void)
+{
+    return host_ticks;
+}
+
+osStatus osMessagePut(osMessageQId queue, uint32_t value, uint32_t)
+{
+    if (queue) static_cast<HostQueue*>(queue)->push_back(value);
+    return osOK;
+}
+
+osEvent osMessageGet(osMessageQId queue, uint32_t)
+{
+    osEvent result{};
+    auto messages = static_cast<HostQueue*>(queue);
+    if (not messages or messages->empty()) {
+        result.status = osEventTimeout;
+        return result;
+    }
+    result.status = osEventMessage;
+    result.value.v = messages->front();
+    messages->pop_front();
+    return result;
+}
+
+// The DMA and its timers are driven by the tests.
+HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef*) { return HAL_OK; }
+HAL_StatusTypeDef HAL_TIM_Base_Stop(TIM_HandleTypeDef*) { return HAL_OK; }
+
+HAL_StatusTypeDef HAL_DAC_Start_DMA(DAC_HandleTypeDef*, uint32_t, uint32_t*,
+    uint32_t, uint32_t)
+{
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DAC_Stop_DMA(DAC_HandleTypeDef*, uint32_t)
+{
+    return HAL_OK;
+}
+
+void log_(int, const char*, ...) {}
+
+} // extern "C"
@@ -0,0 +1,97 @@
+// Copyright 2019 Rob Riggs <rob@mobilinkd.com>
+// All rights reserved.
+
+/// Host stand-in for the CubeMX main.h: pins, GPIO and error handler.
+
+#ifndef MOBILINKD__TEST__HOST_MAIN_H_
+#define MOBILINKD__TEST__HOST_MAIN_H_
+
+#include "cmsis_os.h"
+#include <stdint.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+void _Error_Handler(const char*, int);
+#define CxxErrorHandler() _Error_Handler(__FILE__, __LINE__)
+extern osMutexId hardwareInitMutexHandle;
+extern char serial_number_64[17];
+extern uint8_t mac_address[6];
+extern char error_message[80];
+#ifdef __cplusplus
+}
+#endif
+#define EEPROM_ADDRESS 0xA0
+#define EEPROM_CAPACITY 4096
+#define EEPROM_PAGE_SIZE 32
+#define EEPROM_WRITE_TIME 5
+typedef struct { uint32_t x; } GPIO_TypeDef;
+typedef enum { GPIO_PIN_RESET = 0, GPIO_PIN_SET } GPIO_PinState;
+#ifdef __cplusplus
+extern "C" {
+#endif
+static inline void HAL_GPIO_WritePin(GPIO_TypeDef*, uint16_t, GPIO_PinState) {}
+static inline void HAL_GPIO_TogglePin(GPIO_TypeDef*, uint16_t) {}
+static inline GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef*, uint16_t) { return GPIO_PIN_RESET; }
+#ifdef __cplusplus
+}
+#endif
+#define AUDIO_ATTEN_Pin 1
+#define AUDIO_ATTEN_GPIO_Port 0x48000000u
+#define BAT_DIVIDER_Pin 1
+#define BAT_DIVIDER_GPIO_Port 0x48000000u
+#define BT_CMD_Pin 1
+#define BT_CMD_GPIO_Port 0x48000000u
+#define BT_RESET_Pin 1
+#define BT_RESET_GPIO_Port 0x48000000u
+#define BT_SLEEP_Pin 1
+#define BT_SLEEP_GPIO_Port 0x48000000u
+#define BT_STATE1_Pin 1
+#define BT_STATE1_GPIO_Port 0x48000000u
+#define BT_STATE2_Pin 1
+#define BT_STATE2_GPIO_Port 0x48000000u
+#define BT_WAKE_Pin 1
+#define BT_WAKE_GPIO_Port 0x48000000u
+#define LED_BT_Pin 1
+#define LED_BT_GPIO_Port 0x48000000u
+#define LED_RX_Pin 1
+#define LED_RX_GPIO_Port 0x48000000u
+#define LED_TX_Pin 1
+#define LED_TX_GPIO_Port 0x48000000u
+#define PTT_A_Pin 1
+#define PTT_A_GPIO_Port 0x48000000u
+#define PTT_B_Pin 1
+#define PTT_B_GPIO_Port 0x48000000u
+#define SW_POWER_Pin 1
+#define SW_POWER_GPIO_Port 0x48000000u
+#define USB_CE_Pin 1
+#define USB_CE_GPIO_Port 0x48000000u
+#define USB_POWER_Pin 1
+#define USB_POWER_GPIO_Port 0x48000000u
+#define VDD_EN_Pin 1
+#define VDD_EN_GPIO_Port 0x48000000u
+#define AUDIO_OUT_ATTEN_Pin 1
+#define AUDIO_OUT_ATTEN_GPIO_Port 0x48000000u
+#define GPIOA_BASE 0x48000000u
+#define GPIOB_BASE 0x48000000u
+#define GPIOC_BASE 0x48000000u
+#define GPIOD_BASE 0x48000000u
+#define GPIOE_BASE 0x48000000u
+#define GPIOH_BASE 0x48000000u
+#define GPIO_PIN_0 (1u<<0)
+#define GPIO_PIN_1 (1u<<1)
+#define GPIO_PIN_2 (1u<<2)
+#define GPIO_PIN_3 (1u<<3)
+#define GPIO_PIN_4 (1u<<4)
+#define GPIO_PIN_5 (1u<<5)
+#define GPIO_PIN_6 (1u<<6)
+#define GPIO_PIN_7 (1u<<7)
+#define GPIO_PIN_8 (1u<<8)
+#define GPIO_PIN_9 (1u<<9)
+#define GPIO_PIN_10 (1u<<10)
+#define GPIO_PIN_11 (1u<<11)
+#define GPIO_PIN_12 (1u<<12)
+#define GPIO_PIN_13 (1u<<13)
+#define GPIO_PIN_14 (1u<<14)
+#define GPIO_PIN_15 (1u<<15)
+
+#endif // MOBILINKD__TEST__HOST_MAIN_H_
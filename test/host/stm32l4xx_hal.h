@@ -0,0 +1,98 @@
+// Copyright 2019 Rob Riggs <rob@mobilinkd.com>
+// All rights reserved.
+
+/// Host stand-in for the STM32L4 HAL; declarations only, for the DSP code.
+
+#ifndef MOBILINKD__TEST__HOST_STM32L4XX_HAL_H_
+#define MOBILINKD__TEST__HOST_STM32L4XX_HAL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "core_cm4.h"
+typedef enum { HAL_OK = 0, HAL_ERROR } HAL_StatusTypeDef;
+typedef struct { uint32_t Period; uint32_t Prescaler; } TIM_InitTypeDef;
+typedef struct { void* Instance; TIM_InitTypeDef Init; } TIM_HandleTypeDef;
+typedef struct { uint32_t Ratio, RightBitShift, TriggeredMode, OversamplingStopReset; } ADC_OversamplingTypeDef;
+typedef struct { uint32_t OversamplingMode; ADC_OversamplingTypeDef Oversampling; uint32_t Resolution; } ADC_InitTypeDef;
+typedef struct { void* Instance; ADC_InitTypeDef Init; } ADC_HandleTypeDef;
+typedef struct { uint32_t Channel, Rank, SingleDiff, SamplingTime, OffsetNumber, Offset; } ADC_ChannelConfTypeDef;
+typedef struct { int x; } CRC_HandleTypeDef;
+typedef struct { int x; } DAC_HandleTypeDef;
+typedef struct { uint32_t Mode, PgaGain; } OPAMP_InitTypeDef;
+typedef struct { OPAMP_InitTypeDef Init; } OPAMP_HandleTypeDef;
+#define OPAMP_FOLLOWER_MODE 0
+#define OPAMP_PGA_MODE 1
+#define OPAMP_PGA_GAIN_2 2
+#define OPAMP_PGA_GAIN_4 4
+#define OPAMP_PGA_GAIN_8 8
+#define OPAMP_PGA_GAIN_16 16
+
+#define ADC_CHANNEL_8 8
+#define ADC_CHANNEL_15 15
+#define ADC_CHANNEL_VREFINT 0x100
+#define ADC_REGULAR_RANK_1 1
+#define ADC_SINGLE_ENDED 0
+#define ADC_SAMPLETIME_12CYCLES_5 2
+#define ADC_SAMPLETIME_247CYCLES_5 6
+#define ADC_OFFSET_NONE 0
+#define ENABLE 1
+#define DISABLE 0
+#define ADC_OVERSAMPLING_RATIO_2 0
+#define ADC_OVERSAMPLING_RATIO_4 1
+#define ADC_OVERSAMPLING_RATIO_8 2
+#define ADC_OVERSAMPLING_RATIO_16 3
+#define ADC_OVERSAMPLING_RATIO_32 4
+#define ADC_OVERSAMPLING_RATIO_64 5
+#define ADC_OVERSAMPLING_RATIO_128 6
+#define ADC_OVERSAMPLING_RATIO_256 7
+#define ADC_RIGHTBITSHIFT_NONE 0
+#define ADC_RIGHTBITSHIFT_1 1
+#define ADC_RIGHTBITSHIFT_2 2
+#define ADC_RIGHTBITSHIFT_3 3
+#define ADC_RIGHTBITSHIFT_4 4
+#define ADC_RIGHTBITSHIFT_5 5
+#define ADC_RIGHTBITSHIFT_6 6
+#define ADC_RIGHTBITSHIFT_7 7
+#define ADC_RIGHTBITSHIFT_8 8
+#define DAC_CHANNEL_1 1
+#define DAC_CHANNEL_2 2
+#define DAC_ALIGN_12B_R 0
+#define UNUSED(x) (void)(x)
+#ifdef __cplusplus
+extern "C" {
+#endif
+HAL_StatusTypeDef HAL_ADC_Stop_DMA(ADC_HandleTypeDef*);
+HAL_StatusTypeDef HAL_ADC_Start_DMA(ADC_HandleTypeDef*, uint32_t*, uint32_t);
+HAL_StatusTypeDef HAL_ADC_ConfigChannel(ADC_HandleTypeDef*, ADC_ChannelConfTypeDef*);
+HAL_StatusTypeDef HAL_ADC_Init(ADC_HandleTypeDef*);
+HAL_StatusTypeDef HAL_ADC_DeInit(ADC_HandleTypeDef*);
+HAL_StatusTypeDef HAL_ADC_Start(ADC_HandleTypeDef*);
+HAL_StatusTypeDef HAL_ADC_Stop(ADC_HandleTypeDef*);
+HAL_StatusTypeDef HAL_ADC_PollForConversion(ADC_HandleTypeDef*, uint32_t);
+uint32_t HAL_ADC_GetValue(ADC_HandleTypeDef*);
+void HAL_Delay(uint32_t);
+extern uint32_t SystemCoreClock;
+HAL_StatusTypeDef HAL_OPAMP_Stop(OPAMP_HandleTypeDef*);
+HAL_StatusTypeDef HAL_OPAMP_Start(OPAMP_HandleTypeDef*);
+HAL_StatusTypeDef HAL_OPAMP_Init(OPAMP_HandleTypeDef*);
+HAL_StatusTypeDef HAL_OPAMP_DeInit(OPAMP_HandleTypeDef*);
+HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef*);
+HAL_StatusTypeDef HAL_TIM_Base_Stop(TIM_HandleTypeDef*);
+HAL_StatusTypeDef HAL_TIM_Base_Init(TIM_HandleTypeDef*);
+uint32_t HAL_CRC_Calculate(CRC_HandleTypeDef*, uint32_t*, uint32_t);
+uint32_t HAL_CRC_Accumulate(CRC_HandleTypeDef*, uint32_t*, uint32_t);
+HAL_StatusTypeDef HAL_DAC_Start_DMA(DAC_HandleTypeDef*, uint32_t, uint32_t*, uint32_t, uint32_t);
+HAL_StatusTypeDef HAL_DAC_Stop_DMA(DAC_HandleTypeDef*, uint32_t);
+HAL_StatusTypeDef HAL_DAC_SetValue(DAC_HandleTypeDef*, uint32_t, uint32_t, uint32_t);
+#ifdef __cplusplus
+}
+#endif
+#include "main.h"
+#define __HAL_TIM_SET_AUTORELOAD(h, v) ((h)->Init.Period = (v))
+#ifndef ADC_CFGR2_OVSR_Pos
+#define ADC_CFGR2_OVSR_Pos (2U)
+#define ADC_CFGR2_OVSS_Pos (5U)
+inline void LL_ADC_ConfigOverSamplingRatioShift(void*, uint32_t, uint32_t) {}
+#endif
+
+#endif // MOBILINKD__TEST__HOST_STM32L4XX_HAL_H_
@@ -0,0 +1,194 @@
+// Copyright 2019 Rob Riggs <rob@mobilinkd.com>
+// All rights reserved.
+
+/*
+ * Check when InputMonitor measures the twist, and time it against the
+ * 1200 baud receive chain it runs beside.
+ *
+ *   input_monitor
+ *
+ * The input is noise with AFSK packets in it.  With no twist request the
+ * monitor must not measure the twist.  Once asked, it must measure the
+ * next TWIST_PIECES pieces without a carrier, skipping the packets, and
+ * give the same mark and space levels as pollInputTwist() computes from
+ * those pieces.
+ */
+
+#include "TestSignal.hpp"
+
+#include "AfskDemodulator.hpp"
+#include "FilterCoefficients.hpp"
+#include "HdlcFrame.hpp"
+#include "InputMonitor.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace mobilinkd::tnc;
+
+namespace {
+
+using audio::ADC_BUFFER_SIZE;
+using audio::SAMPLE_RATE;
+
+typedef std::chrono::steady_clock clock_type;
+typedef InputMonitor<88, SAMPLE_RATE> monitor_type;
+
+/// The ADC blocks, and which of them have a carrier.
+struct Input
+{
+    test::samples_type samples;
+    std::vector<bool> carrier;
+
+    size_t blocks() const { return carrier.size(); }
+    const uint16_t* block(size_t i) const { return &samples[i * ADC_BUFFER_SIZE]; }
+};
+
+/// 0.1s of noise then a packet, 20 times.
+Input makeInput()
+{
+    std::mt19937 random(1);
+    std::normal_distribution<float> noise(0.0, 0.1);
+    test::AfskModulator modulator(SAMPLE_RATE, 1200, 1200, 2200);
+
+    test::audio_type signal;
+    std::vector<std::pair<size_t, size_t>> packets;
+    for (int k = 0; k != 20; ++k) {
+        for (size_t i = 0; i != SAMPLE_RATE / 10; ++i) signal.push_back(noise(random));
+        test::bits_type bits;
+        test::appendFlags(bits, 20);
+        test::appendFrame(bits, test::aprsFrame(k));
+        test::appendFlags(bits, 2);
+        auto start = signal.size();
+        modulator(bits, 0.0, signal);
+        test::addNoise(signal.begin() + start, signal.end(), 20, random);
+        packets.emplace_back(start, signal.size());
+    }
+
+    Input result;
+    result.samples = test::toAdcSamples(signal, audio::virtual_ground, 1500,
+        ADC_BUFFER_SIZE);
+    result.carrier.resize(result.samples.size() / ADC_BUFFER_SIZE);
+    for (auto& packet : packets) {
+        for (size_t i = packet.first / ADC_BUFFER_SIZE;
+                i <= (packet.second - 1) / ADC_BUFFER_SIZE; ++i) {
+            result.carrier[i] = true;
+        }
+    }
+    return result;
+}
+
+/// The pollInputTwist() levels of the first pieces without a carrier from first.
+void reference(const Input& input, size_t first, float& mark, float& space)
+{
+    GoertzelBank<2, 88, SAMPLE_RATE> gf({1200.0, 2200.0});
+    float g1200 = 0.0f;
+    float g2200 = 0.0f;
+    uint32_t pieces = 0;
+    for (size_t i = first; pieces != monitor_type::TWIST_PIECES; ++i) {
+        if (input.carrier[i]) continue;
+        gf(input.block(i), 88);
+        g1200 += 10.0f * log10f(gf[0]);
+        g2200 += 10.0f * log10f(gf[1]);
+        gf.reset();
+        ++pieces;
+    }
+    mark = g1200 / pieces;
+    space = g2200 / pieces;
+}
+
+bool checkIdle(const Input& input)
+{
+    monitor_type monitor;
+    for (size_t i = 0; i != input.blocks(); ++i) {
+        monitor(input.block(i), ADC_BUFFER_SIZE, input.carrier[i]);
+    }
+    printf("  no request: %u pieces measured\n", monitor.pieces_);
+    return monitor.pieces_ == 0 and not monitor.twist_complete();
+}
+
+/// Ask for the twist at block first, and again once it is answered.
+bool checkRequest(const Input& input, size_t first)
+{
+    monitor_type monitor;
+    bool ok = true;
+    for (int request = 0; request != 2; ++request) {
+        size_t carrier = 0;
+        size_t i = first;
+        monitor.start_twist();
+        for (; not monitor.twist_complete(); ++i) {
+            monitor(input.block(i), ADC_BUFFER_SIZE, input.carrier[i]);
+            carrier += input.carrier[i];
+        }
+        monitor.stop_twist();
+
+        float mark, space;
+        reference(input, first, mark, space);
+        printf("  request at block %zu: %zu blocks, %zu with a carrier;"
+            " mark %.2fdB, space %.2fdB, expected %.2fdB, %.2fdB\n",
+            first, i - first, carrier, monitor.mark(), monitor.space(), mark, space);
+        ok = ok and carrier != 0 and monitor.mark() == mark
+            and monitor.space() == space;
+        first = i;
+    }
+    return ok;
+}
+
+/// The time per block, in ns, of f(i): the best of several runs.
+template <typename F>
+double time(const Input& input, F f)
+{
+    auto best = clock_type::duration::max();
+    for (int run = 0; run != 5; ++run) {
+        auto start = clock_type::now();
+        for (size_t i = 0; i != input.blocks(); ++i) f(i);
+        best = std::min(best, clock_type::now() - start);
+    }
+    return std::chrono::duration<double, std::nano>(best).count() / input.blocks();
+}
+
+void timeMonitor(const Input& input)
+{
+    static monitor_type monitor;
+    double levels = time(input, [&](size_t i) {
+        monitor(input.block(i), ADC_BUFFER_SIZE, input.carrier[i]);
+    });
+    double twist = time(input, [&](size_t i) {
+        if (monitor.twist_complete()) monitor.stop_twist();
+        monitor.start_twist();
+        monitor(input.block(i), ADC_BUFFER_SIZE, false);
+    });
+
+    Q15SymmetricFirFilter<ADC_BUFFER_SIZE, audio::FILTER_TAP_NUM> audio_filter;
+    audio_filter.init(audio::bpf_coeffs.data());
+    static afsk1200::FusedDemodulator<3> demod(SAMPLE_RATE);
+    for (size_t j = 0; j != demod.size(); ++j) {
+        demod.init(j, *filter::fir::AfskFixedFilters[6 + 3 * j]);
+    }
+    q15_t normalized[ADC_BUFFER_SIZE];
+    double receive = time(input, [&](size_t i) {
+        arm_offset_q15((q15_t*) input.block(i), 0 - audio::virtual_ground,
+            normalized, ADC_BUFFER_SIZE);
+        for (auto frame : demod(audio_filter(normalized), ADC_BUFFER_SIZE)) {
+            if (frame) hdlc::release(frame);
+        }
+    });
+
+    printf("  per block: levels %.0fns, levels and twist %.0fns,"
+        " 1200 baud receive chain %.0fns\n", levels, twist, receive);
+}
+
+} // namespace
+
+int main()
+{
+    auto input = makeInput();
+    bool ok = checkIdle(input);
+    ok = checkRequest(input, 10) and ok;
+    timeMonitor(input);
+
+    printf(ok ? "OK\n" : "FAIL\n");
+    return ok ? 0 : 1;
+}
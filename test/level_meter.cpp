@@ -0,0 +1,114 @@
+// Copyright 2019 Rob Riggs <rob@mobilinkd.com>
+// All rights reserved.
+
+/*
+ * Compare LevelMeter, which works on two packed samples at a time, with
+ * a scalar reference, on blocks of random ADC samples of each width from
+ * 12 to 15 bits, including blocks that hit 0 and full scale in either
+ * half of the word.
+ *
+ *   level_meter
+ */
+
+#include "LevelMeter.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace mobilinkd::tnc;
+
+namespace {
+
+struct Reference
+{
+    uint16_t min{0xFFFF};
+    uint16_t max{0};
+    uint64_t sum{0};
+    double sum_sq{0.0};
+    uint32_t count{0};
+
+    void operator()(const uint16_t* samples, size_t n)
+    {
+        for (size_t i = 0; i != n; ++i) {
+            min = std::min(min, samples[i]);
+            max = std::max(max, samples[i]);
+            sum += samples[i];
+            sum_sq += double(samples[i]) * samples[i];
+        }
+        count += n;
+    }
+
+    uint16_t avg() const { return sum / count; }
+
+    double rms() const
+    {
+        double mean = double(sum) / count;
+        return std::sqrt(std::max(0.0, sum_sq / count - mean * mean));
+    }
+};
+
+bool check(int bits, int blocks, std::mt19937& random)
+{
+    const uint16_t full_scale = (1 << bits) - 1;
+    const size_t BLOCK_SIZE = 88;
+
+    std::uniform_int_distribution<int> amplitude(0, full_scale / 2);
+    std::uniform_int_distribution<int> position(0, BLOCK_SIZE - 1);
+
+    LevelMeter meter;
+    Reference reference;
+    alignas(4) uint16_t samples[BLOCK_SIZE];
+
+    for (int block = 0; block != blocks; ++block) {
+        // A sine around mid-scale plus noise, with a random level.
+        int level = amplitude(random);
+        std::uniform_int_distribution<int> noise(-level / 8 - 1, level / 8 + 1);
+        for (size_t i = 0; i != BLOCK_SIZE; ++i) {
+            double phase = 0.3 * (block * BLOCK_SIZE + i);
+            int sample = full_scale / 2 + int(level * std::sin(phase)) + noise(random);
+            samples[i] = uint16_t(std::min<int>(std::max(sample, 0), full_scale));
+        }
+        // Clip at the rails in some blocks, in either half of a word.
+        if (block % 7 == 3) samples[position(random)] = 0;
+        if (block % 11 == 5) samples[position(random)] = full_scale;
+
+        meter(samples, BLOCK_SIZE);
+        reference(samples, BLOCK_SIZE);
+
+        if (meter.min() != reference.min or meter.max() != reference.max
+            or meter.avg() != reference.avg()
+            or std::abs(meter.rms() - reference.rms()) > 1.0) {
+            printf("  %d bits, block %d: min %u/%u max %u/%u avg %u/%u rms %u/%.1f\n",
+                bits, block, meter.min(), reference.min, meter.max(), reference.max,
+                meter.avg(), reference.avg(), meter.rms(), reference.rms());
+            return false;
+        }
+
+        // Start again now and then, so both small and large counts are checked.
+        if (block % 100 == 99) {
+            meter.reset();
+            reference = Reference();
+        }
+    }
+
+    printf("  %d bits: %d blocks match\n", bits, blocks);
+    return true;
+}
+
+} // namespace
+
+int main()
+{
+    std::mt19937 random(1);
+    bool ok = true;
+    for (int bits = 12; bits <= 15; ++bits) {
+        ok = check(bits, 10000, random) and ok;
+    }
+
+    printf(ok ? "OK\n" : "FAIL\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,429 @@
+// Copyright 2019 Rob Riggs <rob@mobilinkd.com>
+// All rights reserved.
+
+/*
+ * Replay audio through the 1200 baud receive chain of
+ * afsk1200DemodulatorTask(): arm_offset_q15, the band-pass audio_filter
+ * and the three branch afsk1200 demodulator, with the adaptive twist; or,
+ * with -b 300, through the 300 baud HF demodulator with its tone offsets.
+ * Reports the frames decoded and the host time spent in each stage per
+ * ADC block, so that changes to the DSP code can be compared on the same
+ * recording.
+ *
+ *   replay [-b 1200|300] [-t twist] [file]
+ *
+ * The file is a 16-bit mono WAV file at audio::SAMPLE_RATE (26400Hz), or
+ * raw unsigned 16-bit ADC samples as read from the ADC at ADC_SAMPLE_BITS
+ * with the virtual ground at mid-scale.  Resample recordings first, for
+ * example "sox in.wav -r 26400 -c 1 -b 16 out.wav".  twist is the rx_twist
+ * setting, 0 by default.
+ *
+ * With no file, generated signals are used for both: 1200 baud frames at
+ * several twists and noise levels, and 300 baud frames with the receiver
+ * mistuned by up to 80Hz.  The exit status is non-zero unless every frame
+ * is decoded.  Then 1200 baud frames that are all 9dB off in either
+ * direction are replayed with the twist fixed at twist and with the
+ * adaptive twist.  The adaptive twist must move toward the signal and
+ * decode at least as many frames.
+ */
+
+#include "TestSignal.hpp"
+
+#include "AdaptiveTwist.hpp"
+#include "AfskDemodulator.hpp"
+#include "Afsk300Demodulator.hpp"
+#include "FilterCoefficients.hpp"
+#include "HdlcFrame.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+#include <string>
+#include <utility>
+
+using namespace mobilinkd::tnc;
+
+namespace {
+
+using audio::ADC_BUFFER_SIZE;
+using audio::FILTER_TAP_NUM;
+using audio::bpf_coeffs;
+using audio::SAMPLE_RATE;
+
+typedef std::chrono::steady_clock clock_type;
+
+struct Stage
+{
+    const char* name;
+    clock_type::duration elapsed{};
+};
+
+bool readFile(const char* path, test::samples_type& samples)
+{
+    FILE* file = fopen(path, "rb");
+    if (not file) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+
+    std::vector<uint8_t> data;
+    uint8_t buffer[4096];
+    size_t size;
+    while ((size = fread(buffer, 1, sizeof(buffer), file)) != 0) {
+        data.insert(data.end(), buffer, buffer + size);
+    }
+    fclose(file);
+
+    auto u16 = [&data](size_t i) { return uint32_t(data[i] | (data[i + 1] << 8)); };
+    auto u32 = [&u16](size_t i) { return u16(i) | (u16(i + 2) << 16); };
+
+    if (data.size() < 12 or memcmp(data.data(), "RIFF", 4) != 0
+        or memcmp(data.data() + 8, "WAVE", 4) != 0) {
+        // Raw ADC samples.
+        for (size_t i = 0; i + 1 < data.size(); i += 2) samples.push_back(u16(i));
+        return true;
+    }
+
+    size_t pos = 12;
+    bool format_ok = false;
+    while (pos + 8 <= data.size()) {
+        std::string id(data.begin() + pos, data.begin() + pos + 4);
+        size_t chunk_size = std::min<size_t>(u32(pos + 4), data.size() - pos - 8);
+        size_t body = pos + 8;
+        if (id == "fmt " and chunk_size >= 16) {
+            auto format = u16(body), channels = u16(body + 2);
+            auto rate = u32(body + 4), bits = u16(body + 14);
+            format_ok = format == 1 and channels == 1 and bits == 16
+                and rate == SAMPLE_RATE;
+            if (not format_ok) {
+                fprintf(stderr, "%s: need 16-bit mono PCM at %luHz, not "
+                    "%lu-bit, %lu channels at %luHz\n", path,
+                    (unsigned long) SAMPLE_RATE, (unsigned long) bits,
+                    (unsigned long) channels, (unsigned long) rate);
+                return false;
+            }
+        } else if (id == "data" and format_ok) {
+            // Signed 16-bit to ADC_BITS around the virtual ground.
+            for (size_t i = body; i + 1 < body + chunk_size; i += 2) {
+                int16_t sample = int16_t(u16(i));
+                samples.push_back(uint16_t(audio::virtual_ground
+                    + (sample >> (16 - audio::ADC_BITS))));
+            }
+            return true;
+        }
+        pos = body + chunk_size + (chunk_size & 1);
+    }
+
+    fprintf(stderr, "%s: no audio found\n", path);
+    return false;
+}
+
+/// Frames at every combination of twist and SNR, separated by noise.
+test::samples_type generateSignal(std::set<uint32_t>& sent)
+{
+    constexpr int FRAMES = 120;
+    const double TWIST[] = {-6, -3, 0, 3, 6};
+    const double SNR[] = {20, 12, 9, 6};
+
+    std::mt19937 random(1);
+    std::normal_distribution<float> noise(0.0, 0.05);
+
+    test::AfskModulator modulator(SAMPLE_RATE, 1200, 1200, 2200);
+    test::audio_type signal;
+    for (int k = 0; k != FRAMES; ++k) {
+        for (size_t i = 0; i != SAMPLE_RATE / 10; ++i) signal.push_back(noise(random));
+
+        auto frame = test::aprsFrame(k);
+        // The decoded frames include the FCS.
+        sent.insert((uint32_t(frame.size() + 2) << 16) | test::fcs(frame));
+
+        test::bits_type bits;
+        test::appendFlags(bits, 30);
+        test::appendFrame(bits, frame);
+        test::appendFlags(bits, 3);
+
+        auto start = signal.size();
+        modulator(bits, TWIST[k % 5], signal);
+        test::addNoise(signal.begin() + start, signal.end(), SNR[k % 4], random);
+    }
+
+    return test::toAdcSamples(signal, audio::virtual_ground, 3000, ADC_BUFFER_SIZE);
+}
+
+/**
+ * Frames all at one twist, as from a radio with the wrong de-emphasis,
+ * at several SNRs, separated by noise.
+ */
+test::samples_type generateTwistedSignal(double twist, std::set<uint32_t>& sent)
+{
+    constexpr int FRAMES = 60;
+    const double SNR[] = {9, 6, 4};
+
+    std::mt19937 random(3);
+    std::normal_distribution<float> noise(0.0, 0.05);
+
+    test::AfskModulator modulator(SAMPLE_RATE, 1200, 1200, 2200);
+    test::audio_type signal;
+    for (int k = 0; k != FRAMES; ++k) {
+        for (size_t i = 0; i != SAMPLE_RATE / 10; ++i) signal.push_back(noise(random));
+
+        auto frame = test::aprsFrame(k);
+        sent.insert((uint32_t(frame.size() + 2) << 16) | test::fcs(frame));
+
+        test::bits_type bits;
+        test::appendFlags(bits, 30);
+        test::appendFrame(bits, frame);
+        test::appendFlags(bits, 3);
+
+        auto start = signal.size();
+        modulator(bits, twist, signal);
+        test::addNoise(signal.begin() + start, signal.end(),
+            SNR[k % std::size(SNR)], random);
+    }
+
+    return test::toAdcSamples(signal, audio::virtual_ground, 3000, ADC_BUFFER_SIZE);
+}
+
+/**
+ * 300 baud HF frames with the receiver mistuned by up to 80Hz, at several
+ * SNRs, separated by noise.  The demodulator's offsets are 40Hz apart.
+ */
+test::samples_type generateHfSignal(std::set<uint32_t>& sent)
+{
+    constexpr int FRAMES = 40;
+    const double TUNING[] = {-80, -40, 0, 20, 40, 60, 80};
+    const double SNR[] = {20, 12, 9, 6};
+
+    std::mt19937 random(2);
+    std::normal_distribution<float> noise(0.0, 0.05);
+
+    test::audio_type signal;
+    for (int k = 0; k != FRAMES; ++k) {
+        for (size_t i = 0; i != SAMPLE_RATE / 2; ++i) signal.push_back(noise(random));
+
+        auto frame = test::aprsFrame(k);
+        sent.insert((uint32_t(frame.size() + 2) << 16) | test::fcs(frame));
+
+        test::bits_type bits;
+        test::appendFlags(bits, 10);
+        test::appendFrame(bits, frame);
+        test::appendFlags(bits, 3);
+
+        double tuning = TUNING[k % 7];
+        test::AfskModulator modulator(SAMPLE_RATE, afsk300::BIT_RATE,
+            afsk300::MARK_FREQ + tuning, afsk300::SPACE_FREQ + tuning);
+        auto start = signal.size();
+        modulator(bits, 0.0, signal);
+        test::addNoise(signal.begin() + start, signal.end(), SNR[k % 4], random);
+    }
+
+    return test::toAdcSamples(signal, audio::virtual_ground, 3000, ADC_BUFFER_SIZE);
+}
+
+/// The frames decoded and the time spent in each stage.
+struct Replay
+{
+    Stage stages[3] = {{"offset"}, {"filter"}, {"demod"}};
+    size_t blocks{0};
+    size_t frames{0};
+    std::set<uint32_t> unique;
+    int twist{0};           ///< The final 1200 baud twist.
+
+    void decoded(hdlc::IoFrame* frame)
+    {
+        ++frames;
+        unique.insert(key(frame));
+        hdlc::release(frame);
+    }
+
+    static uint32_t key(hdlc::IoFrame* frame)
+    {
+        return (uint32_t(frame->size()) << 16) | frame->fcs();
+    }
+
+    void report(const char* name, const char* detail) const
+    {
+        double seconds = double(blocks * ADC_BUFFER_SIZE) / SAMPLE_RATE;
+        printf("%s: %zu blocks (%.1fs), %zu frames, %zu unique%s\n", name,
+            blocks, seconds, frames, unique.size(), detail);
+
+        double total = 0.0;
+        for (auto& stage : stages) {
+            double ns = std::chrono::duration<double, std::nano>(stage.elapsed).count();
+            total += ns;
+            printf("  %-8s %8.0fns/block\n", stage.name, ns / std::max<size_t>(blocks, 1));
+        }
+        printf("  %-8s %8.0fns/block, %.0fx real time\n", "total",
+            total / std::max<size_t>(blocks, 1), seconds * 1e9 / std::max(total, 1.0));
+    }
+
+    /// Check that every frame sent was decoded, and nothing else.
+    bool check(const std::set<uint32_t>& sent) const
+    {
+        size_t missed = 0;
+        for (auto key : sent) missed += unique.count(key) == 0;
+        if (missed or unique.size() != sent.size()) {
+            printf("FAIL: %zu of %zu frames missed, %zu unexpected\n", missed,
+                sent.size(), unique.size() - (sent.size() - missed));
+            return false;
+        }
+        printf("OK: all %zu frames decoded\n", sent.size());
+        return true;
+    }
+};
+
+/**
+ * Run the samples through the band-pass filter and the demodulator, in
+ * blocks.  The demodulator's decode() is given the block and the frames
+ * it returns.
+ */
+template <typename Decode>
+void run(const test::samples_type& samples, Replay& replay, Decode decode)
+{
+    Q15SymmetricFirFilter<ADC_BUFFER_SIZE, FILTER_TAP_NUM> audio_filter;
+    audio_filter.init(bpf_coeffs.data());
+
+    q15_t normalized[ADC_BUFFER_SIZE];
+    replay.blocks = samples.size() / ADC_BUFFER_SIZE;
+
+    for (size_t block = 0; block != replay.blocks; ++block) {
+        auto t0 = clock_type::now();
+        arm_offset_q15((q15_t*) &samples[block * ADC_BUFFER_SIZE],
+            0 - audio::virtual_ground, normalized, ADC_BUFFER_SIZE);
+        auto t1 = clock_type::now();
+        q15_t* audio = audio_filter(normalized);
+        auto t2 = clock_type::now();
+        decode(audio);
+        auto t3 = clock_type::now();
+
+        replay.stages[0].elapsed += t1 - t0;
+        replay.stages[1].elapsed += t2 - t1;
+        replay.stages[2].elapsed += t3 - t2;
+    }
+}
+
+/**
+ * The three branch 1200 baud demodulator, starting at twist dB, with the
+ * adaptive twist unless adaptive is false.
+ */
+void replay1200(const test::samples_type& samples, int twist, Replay& replay,
+    bool adaptive = AFSK_ADAPTIVE_TWIST)
+{
+    static afsk1200::FusedDemodulator<3> demod(SAMPLE_RATE);
+    AdaptiveTwist<3> adaptive_twist(twist);
+    for (size_t i = 0; i != demod.size(); ++i) {
+        demod.init(i, *filter::fir::AfskFixedFilters[adaptive_twist[i] + 6]);
+    }
+
+    run(samples, replay, [&](const q15_t* audio) {
+        auto decoded = demod(audio, ADC_BUFFER_SIZE);
+        for (size_t i = 0; i != decoded.size(); ++i) {
+            auto frame = decoded[i];
+            if (not frame) continue;
+            if (adaptive) adaptive_twist(i, Replay::key(frame));
+            replay.decoded(frame);
+        }
+
+        if (adaptive_twist.changed() and not demod.locked()) {
+            for (size_t i = 0; i != demod.size(); ++i) {
+                demod.taps(i, *filter::fir::AfskFixedFilters[adaptive_twist[i] + 6]);
+            }
+            adaptive_twist.applied();
+        }
+    });
+
+    replay.twist = adaptive_twist.center();
+    std::string detail = ", twist " + std::to_string(replay.twist) + "dB";
+    replay.report(adaptive ? "1200 baud" : "1200 baud (static twist)", detail.c_str());
+}
+
+/// The 300 baud HF demodulator, with its tone offsets.
+void replay300(const test::samples_type& samples, Replay& replay)
+{
+    static afsk300::Demodulator demod(afsk300::MARK_FREQ, afsk300::SPACE_FREQ);
+    demod.init();
+
+    run(samples, replay, [&](const q15_t* audio) {
+        for (auto frame : demod(audio, ADC_BUFFER_SIZE)) {
+            if (frame) replay.decoded(frame);
+        }
+    });
+
+    replay.report("300 baud", "");
+}
+
+/**
+ * Check that the adaptive twist moved against the twist of the signal
+ * (a weak space tone needs more emphasis) and decoded at least as many
+ * frames as the static twist.
+ */
+bool checkAdaptiveTwist(int signal_twist, int start, const Replay& fixed,
+    const Replay& adaptive, size_t sent)
+{
+    bool moved = signal_twist < 0 ? adaptive.twist > start : adaptive.twist < start;
+    bool ok = moved and adaptive.unique.size() >= fixed.unique.size();
+    printf("%s: signal twist %ddB, twist %ddB -> %ddB, %zu of %zu frames"
+        " decoded (%zu static)\n", ok ? "OK" : "FAIL", signal_twist, start,
+        adaptive.twist, adaptive.unique.size(), sent, fixed.unique.size());
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    int twist = 0;
+    int baud = 1200;
+    const char* path = nullptr;
+    for (int i = 1; i != argc; ++i) {
+        if (std::string(argv[i]) == "-t" and i + 1 != argc) {
+            twist = atoi(argv[++i]);
+        } else if (std::string(argv[i]) == "-b" and i + 1 != argc) {
+            baud = atoi(argv[++i]);
+        } else if (argv[i][0] == '-') {
+            baud = 0;   // Usage.
+            break;
+        } else {
+            path = argv[i];
+        }
+    }
+    if (baud != 1200 and baud != 300) {
+        fprintf(stderr, "usage: %s [-b 1200|300] [-t twist] [file.wav | file.raw]\n",
+            argv[0]);
+        return 2;
+    }
+
+    if (path) {
+        test::samples_type samples;
+        if (not readFile(path, samples)) return 2;
+        Replay replay;
+        if (baud == 1200) replay1200(samples, twist, replay);
+        else replay300(samples, replay);
+        return 0;
+    }
+
+    bool ok = true;
+    {
+        std::set<uint32_t> sent;
+        Replay replay;
+        replay1200(generateSignal(sent), twist, replay);
+        ok = replay.check(sent) and ok;
+    }
+    {
+        std::set<uint32_t> sent;
+        Replay replay;
+        replay300(generateHfSignal(sent), replay);
+        ok = replay.check(sent) and ok;
+    }
+    for (int signal_twist : {-9, 9}) {
+        std::set<uint32_t> sent;
+        auto samples = generateTwistedSignal(signal_twist, sent);
+        Replay fixed, adaptive;
+        replay1200(samples, twist, fixed, false);
+        replay1200(samples, twist, adaptive, true);
+        ok = checkAdaptiveTwist(signal_twist, AdaptiveTwist<3>::clamp(twist), fixed,
+            adaptive, sent.size()) and ok;
+    }
+    return ok ? 0 : 1;
+}